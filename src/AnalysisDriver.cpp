@@ -4,18 +4,63 @@ AnalysisDriver::AnalysisDriver(tracer_state_t &tracer_state,
                                const std::string &output_dir, bool truncate,
                                bool binary, int compression_level,
                                const AnalysisSwitch analysis_switch)
-    : analysis_switch_{analysis_switch},
-      promise_mapper_{tracer_state, output_dir},
-      metadata_analysis_{tracer_state, output_dir},
+    : tracer_state_{tracer_state}, analysis_switch_{analysis_switch},
+      promise_mapper_{tracer_state, output_dir, truncate, binary,
+                      compression_level},
+      metadata_analysis_{tracer_state, output_dir, truncate, binary,
+                         compression_level},
       object_count_size_analysis_{tracer_state, output_dir},
-      function_analysis_{tracer_state, output_dir},
+      function_analysis_{tracer_state, output_dir, truncate, binary,
+                         compression_level},
       promise_evaluation_analysis_{tracer_state, output_dir, &promise_mapper_},
       promise_type_analysis_{tracer_state, output_dir},
-      strictness_analysis_{tracer_state, &promise_mapper_, output_dir,
-                           truncate,     binary,           compression_level},
+      strictness_analysis_{tracer_state,
+                           &promise_mapper_,
+                           output_dir,
+                           truncate,
+                           binary,
+                           compression_level,
+                           analysis_switch.aggregate_parameter_usage},
       side_effect_analysis_{tracer_state, output_dir, truncate, binary,
-                            compression_level} {
+                            compression_level},
+      memory_timeline_data_table_{nullptr}, event_log_{nullptr},
+      degradations_data_table_{nullptr}, primitives_data_table_{nullptr},
+      locations_data_table_{nullptr} {
     std::cout << analysis_switch;
+
+    if (sample_memory()) {
+        memory_timeline_data_table_ = create_data_table(
+            output_dir + "/" + "memory-timeline",
+            {"gc_counter", "component", "entries", "bytes"}, truncate, binary,
+            compression_level);
+    }
+
+    if (write_primitives()) {
+        primitives_data_table_ =
+            create_data_table(output_dir + "/" + "primitives",
+                              {"name", "type", "calls"}, truncate, binary,
+                              compression_level);
+    }
+
+    if (needs_locations()) {
+        locations_data_table_ = create_data_table(
+            output_dir + "/" + "locations", {"id", "location"}, truncate,
+            binary, compression_level);
+    }
+
+    if (degrade_calls()) {
+        degradations_data_table_ = create_data_table(
+            output_dir + "/" + "degradations",
+            {"function_id", "reason", "traced_calls", "call_rate", "calls",
+             "degraded_calls"},
+            truncate, binary, compression_level);
+    }
+
+    if (record_events()) {
+        event_log_ = new EventLog(output_dir + "/" + "events.bin" +
+                                      (compression_level == 0 ? "" : ".zst"),
+                                  compression_level);
+    }
 }
 
 void AnalysisDriver::begin(dyntracer_t *dyntracer) {}
@@ -24,6 +69,10 @@ void AnalysisDriver::promise_created(const prom_basic_info_t &prom_basic_info,
                                      const SEXP promise) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->promise(EventType::PROMISE_CREATED, prom_basic_info,
+                            promise);
+
     // WARNING: This has to be at the beginning. This adds promises to the
     // mapping. These promises are used by the analysis below.
     if (map_promises())
@@ -43,6 +92,9 @@ void AnalysisDriver::promise_created(const prom_basic_info_t &prom_basic_info,
 void AnalysisDriver::closure_entry(const closure_info_t &closure_info) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->call(EventType::CLOSURE_ENTRY, closure_info);
+
     // WARNING: This has to be at the beginning. This updates promises
     // in the mapping. These promises are used by the analysis below.
     if (map_promises())
@@ -69,6 +121,9 @@ void AnalysisDriver::closure_entry(const closure_info_t &closure_info) {
 void AnalysisDriver::special_entry(const builtin_info_t &special_info) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->call(EventType::SPECIAL_ENTRY, special_info);
+
     if (analyze_functions())
         function_analysis_.special_entry(special_info);
 
@@ -78,6 +133,9 @@ void AnalysisDriver::special_entry(const builtin_info_t &special_info) {
 void AnalysisDriver::builtin_entry(const builtin_info_t &builtin_info) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->call(EventType::BUILTIN_ENTRY, builtin_info);
+
     if (analyze_functions())
         function_analysis_.builtin_entry(builtin_info);
 
@@ -87,6 +145,9 @@ void AnalysisDriver::builtin_entry(const builtin_info_t &builtin_info) {
 void AnalysisDriver::closure_exit(const closure_info_t &closure_info) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->call(EventType::CLOSURE_EXIT, closure_info);
+
     if (analyze_functions())
         function_analysis_.closure_exit(closure_info);
 
@@ -101,6 +162,9 @@ void AnalysisDriver::closure_exit(const closure_info_t &closure_info) {
 void AnalysisDriver::builtin_exit(const builtin_info_t &builtin_info) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->call(EventType::BUILTIN_EXIT, builtin_info);
+
     if (analyze_functions())
         function_analysis_.builtin_exit(builtin_info);
 
@@ -110,6 +174,9 @@ void AnalysisDriver::builtin_exit(const builtin_info_t &builtin_info) {
 void AnalysisDriver::special_exit(const builtin_info_t &special_info) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->call(EventType::SPECIAL_EXIT, special_info);
+
     if (analyze_functions())
         function_analysis_.special_exit(special_info);
 
@@ -120,6 +187,9 @@ void AnalysisDriver::promise_force_entry(const prom_info_t &prom_info,
                                          const SEXP promise) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->promise(EventType::PROMISE_FORCE_ENTRY, prom_info, promise);
+
     if (map_promises())
         promise_mapper_.promise_force_entry(prom_info, promise);
 
@@ -141,6 +211,9 @@ void AnalysisDriver::promise_force_exit(const prom_info_t &prom_info,
                                         const SEXP promise) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->promise(EventType::PROMISE_FORCE_EXIT, prom_info, promise);
+
     if (analyze_promise_types())
         promise_type_analysis_.promise_force_exit(prom_info, promise);
 
@@ -151,6 +224,9 @@ void AnalysisDriver::gc_promise_unmarked(const prom_id_t prom_id,
                                          const SEXP promise) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->gc_promise_unmarked(prom_id, promise);
+
     // if (analyze_strictness())
     //     strictness_analysis_.gc_promise_unmarked(prom_id, promise);
 
@@ -161,6 +237,11 @@ void AnalysisDriver::gc_promise_unmarked(const prom_id_t prom_id,
 
     ANALYSIS_TIMER_END_SEGMENT(GC_PROMISE_UNMARKED_ANALYSIS_PROMISE_TYPE);
 
+    if (analyze_side_effects())
+        side_effect_analysis_.gc_promise_unmarked(prom_id, promise);
+
+    ANALYSIS_TIMER_END_SEGMENT(GC_PROMISE_UNMARKED_ANALYSIS_SIDE_EFFECT);
+
     // WARNING: This has to be at the end. This removes promises from the
     // mapping. These promises are used by the analysis above.
     if (map_promises())
@@ -169,10 +250,51 @@ void AnalysisDriver::gc_promise_unmarked(const prom_id_t prom_id,
     ANALYSIS_TIMER_END_SEGMENT(GC_PROMISE_UNMARKED_ANALYSIS_PROMISE_MAPPER);
 }
 
+void AnalysisDriver::gc_environment_unmarked(const SEXP environment) {
+    ANALYSIS_TIMER_RESET();
+
+    if (record_events())
+        event_log_->gc_environment_unmarked(environment);
+
+    // WARNING: This has to be called before the environment is removed from
+    // the tracer state. The analyses use it to find the variables of the
+    // environment.
+    if (analyze_side_effects())
+        side_effect_analysis_.gc_environment_unmarked(environment);
+
+    ANALYSIS_TIMER_END_SEGMENT(GC_ENVIRONMENT_UNMARKED_ANALYSIS_SIDE_EFFECT);
+}
+
+void AnalysisDriver::gc_exit(const gc_info_t &info) {
+    ANALYSIS_TIMER_RESET();
+
+    if (record_events())
+        event_log_->gc_exit(info);
+
+    /* a gc is a natural point to sample memory, the heap has just been
+       swept and the unmarked objects have been removed from the state. */
+    if (sample_memory()) {
+        MemoryAccount account;
+        account_memory(account);
+        for (const auto &usage : account.get_usages()) {
+            memory_timeline_data_table_->write_row(
+                info.counter, usage.component,
+                static_cast<double>(usage.entries),
+                static_cast<double>(usage.bytes));
+        }
+    }
+
+    ANALYSIS_TIMER_END_SEGMENT(GC_EXIT_ANALYSIS);
+}
+
 void AnalysisDriver::promise_environment_lookup(const prom_info_t &info,
                                                 const SEXP promise) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->promise(EventType::PROMISE_ENVIRONMENT_LOOKUP, info,
+                            promise);
+
     if (map_promises())
         promise_mapper_.promise_environment_lookup(info, promise);
 
@@ -190,6 +312,10 @@ void AnalysisDriver::promise_expression_lookup(const prom_info_t &info,
 
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->promise(EventType::PROMISE_EXPRESSION_LOOKUP, info,
+                            promise);
+
     if (map_promises())
         promise_mapper_.promise_expression_lookup(info, promise);
 
@@ -206,6 +332,9 @@ void AnalysisDriver::promise_value_lookup(const prom_info_t &info,
                                           const SEXP promise) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->promise(EventType::PROMISE_VALUE_LOOKUP, info, promise);
+
     if (map_promises())
         promise_mapper_.promise_value_lookup(info, promise);
 
@@ -220,6 +349,9 @@ void AnalysisDriver::promise_environment_set(const prom_info_t &info,
                                              const SEXP promise) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->promise(EventType::PROMISE_ENVIRONMENT_SET, info, promise);
+
     if (map_promises())
         promise_mapper_.promise_environment_set(info, promise);
 
@@ -235,6 +367,9 @@ void AnalysisDriver::promise_expression_set(const prom_info_t &info,
                                             const SEXP promise) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->promise(EventType::PROMISE_EXPRESSION_SET, info, promise);
+
     if (map_promises())
         promise_mapper_.promise_expression_set(info, promise);
 
@@ -250,6 +385,9 @@ void AnalysisDriver::promise_value_set(const prom_info_t &info,
                                        const SEXP promise) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->promise(EventType::PROMISE_VALUE_SET, info, promise);
+
     if (map_promises())
         promise_mapper_.promise_value_set(info, promise);
 
@@ -264,6 +402,9 @@ void AnalysisDriver::promise_value_set(const prom_info_t &info,
 void AnalysisDriver::vector_alloc(const type_gc_info_t &type_gc_info) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->vector_alloc(type_gc_info);
+
     if (analyze_object_count_size())
         object_count_size_analysis_.vector_alloc(type_gc_info);
 
@@ -274,6 +415,10 @@ void AnalysisDriver::environment_define_var(const SEXP symbol, const SEXP value,
                                             const SEXP rho) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->environment_action(EventType::ENVIRONMENT_DEFINE_VAR,
+                                       symbol, value, rho);
+
     if (analyze_side_effects())
         side_effect_analysis_.environment_define_var(symbol, value, rho);
 
@@ -284,6 +429,10 @@ void AnalysisDriver::environment_assign_var(const SEXP symbol, const SEXP value,
                                             const SEXP rho) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->environment_action(EventType::ENVIRONMENT_ASSIGN_VAR,
+                                       symbol, value, rho);
+
     if (analyze_side_effects())
         side_effect_analysis_.environment_assign_var(symbol, value, rho);
 
@@ -294,6 +443,10 @@ void AnalysisDriver::environment_lookup_var(const SEXP symbol, const SEXP value,
                                             const SEXP rho) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->environment_action(EventType::ENVIRONMENT_LOOKUP_VAR,
+                                       symbol, value, rho);
+
     if (analyze_side_effects())
         side_effect_analysis_.environment_lookup_var(symbol, value, rho);
 
@@ -303,15 +456,50 @@ void AnalysisDriver::environment_lookup_var(const SEXP symbol, const SEXP value,
 void AnalysisDriver::environment_remove_var(const SEXP symbol, const SEXP rho) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->environment_action(EventType::ENVIRONMENT_REMOVE_VAR,
+                                       symbol, nullptr, rho);
+
     if (analyze_side_effects())
         side_effect_analysis_.environment_remove_var(symbol, rho);
 
     ANALYSIS_TIMER_END_SEGMENT(ENVIRONMENT_ACTION_ANALYSIS_SIDE_EFFECT);
 }
 
+void AnalysisDriver::environment_action(EventType type,
+                                        const environment_action_t &action) {
+    if (!analyze_side_effects())
+        return;
+
+    ANALYSIS_TIMER_RESET();
+
+    const SEXP rho = reinterpret_cast<SEXP>(action.rho);
+    switch (type) {
+        case EventType::ENVIRONMENT_DEFINE_VAR:
+            side_effect_analysis_.environment_define_var(action.symbol, rho);
+            break;
+        case EventType::ENVIRONMENT_ASSIGN_VAR:
+            side_effect_analysis_.environment_assign_var(action.symbol, rho);
+            break;
+        case EventType::ENVIRONMENT_LOOKUP_VAR:
+            side_effect_analysis_.environment_lookup_var(action.symbol, rho);
+            break;
+        case EventType::ENVIRONMENT_REMOVE_VAR:
+            side_effect_analysis_.environment_remove_var(action.symbol, rho);
+            break;
+        default:
+            break;
+    }
+
+    ANALYSIS_TIMER_END_SEGMENT(ENVIRONMENT_ACTION_ANALYSIS_SIDE_EFFECT);
+}
+
 void AnalysisDriver::context_jump(const unwind_info_t &info) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->context_jump(info);
+
     if (analyze_functions())
         function_analysis_.context_jump(info);
 
@@ -324,6 +512,41 @@ void AnalysisDriver::context_jump(const unwind_info_t &info) {
 void AnalysisDriver::end(dyntracer_t *dyntracer) {
     ANALYSIS_TIMER_RESET();
 
+    if (record_events())
+        event_log_->end();
+
+    if (degrade_calls()) {
+        for (const auto &degradation :
+             tracer_state_.call_degrader.get_degradations()) {
+            degradations_data_table_->write_row(
+                degradation.function_id, degradation.reason,
+                static_cast<double>(degradation.traced_calls),
+                degradation.call_rate, static_cast<double>(degradation.calls),
+                static_cast<double>(degradation.degraded_calls));
+        }
+    }
+
+    if (write_primitives()) {
+        const PrimitiveCounters &primitives = tracer_state_.primitive_counters;
+        for (std::size_t offset = 0; offset < primitives.size(); ++offset) {
+            if (primitives.get_calls(offset) == 0)
+                continue;
+            primitives_data_table_->write_row(
+                std::string(PrimitiveCounters::get_name(offset)),
+                sexptype_to_string(
+                    static_cast<sexptype_t>(primitives.get_type(offset))),
+                static_cast<double>(primitives.get_calls(offset)));
+        }
+    }
+
+    /* the location ids of the info structures index this table */
+    if (needs_locations()) {
+        const LocationCache &locations = tracer_state_.locations;
+        for (location_id_t id = 0; id < (location_id_t)locations.size(); ++id)
+            locations_data_table_->write_row(static_cast<double>(id),
+                                             locations.get(id));
+    }
+
     if (analyze_metadata())
         metadata_analysis_.end(dyntracer);
 
@@ -367,6 +590,44 @@ void AnalysisDriver::end(dyntracer_t *dyntracer) {
     ANALYSIS_TIMER_END_SEGMENT(END_ANALYSIS_PROMISE_MAPPER);
 }
 
+void AnalysisDriver::account_memory(MemoryAccount &account) const {
+    tracer_state_.account_memory(account);
+
+    if (map_promises())
+        promise_mapper_.account_memory(account);
+
+    if (analyze_functions())
+        function_analysis_.account_memory(account);
+
+    if (analyze_promise_types())
+        promise_type_analysis_.account_memory(account);
+
+    if (analyze_promise_evaluations())
+        promise_evaluation_analysis_.account_memory(account);
+
+    if (analyze_strictness())
+        strictness_analysis_.account_memory(account);
+
+    if (analyze_side_effects())
+        side_effect_analysis_.account_memory(account);
+
+    account.add_table("analysis_driver/memory-timeline",
+                      memory_timeline_data_table_);
+}
+
+void AnalysisDriver::add_metadata(const std::string &key,
+                                  const std::string &value) {
+    metadata_analysis_.add_entry(key, value);
+}
+
+AnalysisDriver::~AnalysisDriver() {
+    delete memory_timeline_data_table_;
+    delete event_log_;
+    delete degradations_data_table_;
+    delete primitives_data_table_;
+    delete locations_data_table_;
+}
+
 inline bool AnalysisDriver::analyze_metadata() const {
     return analysis_switch_.metadata;
 }
@@ -403,3 +664,36 @@ inline bool AnalysisDriver::map_promises() const {
     return analysis_switch_.strictness || analysis_switch_.promise_evaluation ||
            analysis_switch_.promise_slot_mutation;
 }
+
+inline bool AnalysisDriver::sample_memory() const {
+    return analysis_switch_.memory_timeline;
+}
+
+inline bool AnalysisDriver::record_events() const {
+    return analysis_switch_.record_events;
+}
+
+/* the calls to primitives are counted in the function analysis */
+inline bool AnalysisDriver::write_primitives() const {
+    return analyze_functions();
+}
+
+/* the function analysis and the event log are the only consumers of the
+   info of builtin and special calls */
+bool AnalysisDriver::needs_builtin_info() const {
+    return analyze_functions() || record_events();
+}
+
+/* no analysis reads the full type of promises, only the event log records
+   it */
+bool AnalysisDriver::needs_full_promise_type() const {
+    return record_events();
+}
+
+/* no analysis reads the locations, only the event log records their ids */
+bool AnalysisDriver::needs_locations() const { return record_events(); }
+
+inline bool AnalysisDriver::degrade_calls() const {
+    return analysis_switch_.degradation_call_limit != 0 ||
+           analysis_switch_.degradation_call_rate != 0;
+}
@@ -2,6 +2,7 @@
 #define __ANALYSIS_DRIVER_H__
 
 #include "AnalysisSwitch.h"
+#include "EventLog.h"
 #include "FunctionAnalysis.h"
 #include "MetadataAnalysis.h"
 #include "ObjectCountSizeAnalysis.h"
@@ -39,6 +40,8 @@ class AnalysisDriver {
     void promise_value_set(const prom_info_t &info, const SEXP promise);
 
     void gc_promise_unmarked(const prom_id_t prom_id, const SEXP promise);
+    void gc_environment_unmarked(const SEXP environment);
+    void gc_exit(const gc_info_t &info);
     void vector_alloc(const type_gc_info_t &type_gc_info);
     void environment_define_var(const SEXP symbol, const SEXP value,
                                 const SEXP rho);
@@ -47,8 +50,15 @@ class AnalysisDriver {
     void environment_lookup_var(const SEXP symbol, const SEXP value,
                                 const SEXP rho);
     void environment_remove_var(const SEXP symbol, const SEXP rho);
+    /* replays a recorded environment action, whose symbol is only known by
+       name, it is not recorded again */
+    void environment_action(EventType type,
+                            const environment_action_t &action);
     void context_jump(const unwind_info_t &info);
     void end(dyntracer_t *dyntracer);
+    void account_memory(MemoryAccount &account) const;
+    void add_metadata(const std::string &key, const std::string &value);
+    ~AnalysisDriver();
 
     inline bool analyze_metadata() const;
     inline bool analyze_object_count_size() const;
@@ -59,8 +69,16 @@ class AnalysisDriver {
     inline bool analyze_strictness() const;
     inline bool analyze_side_effects() const;
     inline bool map_promises() const;
+    inline bool sample_memory() const;
+    inline bool record_events() const;
+    inline bool write_primitives() const;
+    inline bool degrade_calls() const;
+    bool needs_builtin_info() const;
+    bool needs_full_promise_type() const;
+    bool needs_locations() const;
 
   private:
+    const tracer_state_t &tracer_state_;
     PromiseMapper promise_mapper_;
     FunctionAnalysis function_analysis_;
     StrictnessAnalysis strictness_analysis_;
@@ -70,6 +88,11 @@ class AnalysisDriver {
     ObjectCountSizeAnalysis object_count_size_analysis_;
     MetadataAnalysis metadata_analysis_;
     AnalysisSwitch analysis_switch_;
+    DataTableStream *memory_timeline_data_table_;
+    EventLog *event_log_;
+    DataTableStream *degradations_data_table_;
+    DataTableStream *primitives_data_table_;
+    DataTableStream *locations_data_table_;
 };
 
 #endif /* __ANALYSIS_DRIVER_H__ */
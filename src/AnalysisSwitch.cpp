@@ -18,7 +18,20 @@ std::ostream &operator<<(std::ostream &os,
        << "Strictness Analysis             : " << analysis_switch.strictness
        << std::endl
        << "Side Effect Analysis            : " << analysis_switch.side_effect
-       << std::endl;
+       << std::endl
+       << "Aggregate Parameter Usage       : "
+       << analysis_switch.aggregate_parameter_usage << std::endl
+       << "Memory Timeline                 : "
+       << analysis_switch.memory_timeline << std::endl
+       << "Record Events                   : "
+       << analysis_switch.record_events << std::endl
+       << "Sampling                        : "
+       << sampling_mode_to_string(analysis_switch.sampling_mode) << " 1/"
+       << analysis_switch.sampling_rate << std::endl
+       << "Degradation Call Limit          : "
+       << analysis_switch.degradation_call_limit << std::endl
+       << "Degradation Call Rate           : "
+       << analysis_switch.degradation_call_rate << std::endl;
 
     return os;
 }
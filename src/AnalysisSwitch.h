@@ -1,6 +1,7 @@
 #ifndef __ANALYSIS_SWITCH_H__
 #define __ANALYSIS_SWITCH_H__
 
+#include "CallSampler.h"
 #include <iostream>
 
 class AnalysisSwitch {
@@ -13,6 +14,13 @@ class AnalysisSwitch {
     bool promise_evaluation;
     bool strictness;
     bool side_effect;
+    bool aggregate_parameter_usage;
+    bool memory_timeline;
+    bool record_events;
+    sampling_mode_t sampling_mode;
+    int sampling_rate;
+    double degradation_call_limit;
+    double degradation_call_rate;
 
     friend std::ostream &operator<<(std::ostream &os,
                                     const AnalysisSwitch &analysis_switch);
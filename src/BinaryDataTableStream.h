@@ -28,10 +28,10 @@ class BinaryDataTableStream : public DataTableStream {
         } else if (column_types_[get_current_column_index()] != column_type) {
             std::fprintf(
                 stderr,
-                "column type mismatch: expected %s of %d bytes at column "
-                "%lo of file %s",
-                sexptype_to_string(column_type.first).c_str(),
-                column_type.second, get_current_column_index(),
+                "column type mismatch: expected type %u of %d bytes at "
+                "column %lo of file %s",
+                column_type.first, column_type.second,
+                get_current_column_index(),
                 get_filepath().c_str());
             exit(EXIT_FAILURE);
         }
@@ -0,0 +1,48 @@
+#include "CallDegrader.h"
+
+CallDegrader::CallDegrader()
+    : call_limit_{0}, call_rate_{0}, calls_{0}, window_{1}, window_calls_{0},
+      window_start_{std::chrono::steady_clock::now()}, last_call_rate_{0},
+      hottest_{nullptr}, hottest_calls_{0}, over_budget_{nullptr} {}
+
+void CallDegrader::configure(std::uint64_t call_limit, double call_rate) {
+    call_limit_ = call_limit;
+    call_rate_ = call_rate;
+    window_start_ = std::chrono::steady_clock::now();
+}
+
+void CallDegrader::remove(const SEXP function) {
+    if (!is_enabled())
+        return;
+    functions_.erase(function);
+    if (hottest_ == function)
+        hottest_ = nullptr;
+    if (over_budget_ == function)
+        over_budget_ = nullptr;
+}
+
+void CallDegrader::end_window_() {
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - window_start_).count();
+    last_call_rate_ = seconds == 0 ? 0 : window_calls_ / seconds;
+
+    /* the hottest closure of a window over budget is switched over on its
+       next call, unless it was already */
+    if (call_rate_ != 0 && last_call_rate_ > call_rate_ &&
+        hottest_ != nullptr)
+        over_budget_ = hottest_;
+
+    ++window_;
+    window_calls_ = 0;
+    window_start_ = now;
+    hottest_ = nullptr;
+    hottest_calls_ = 0;
+}
+
+void CallDegrader::degrade_(function_t &function,
+                            const std::string &function_id,
+                            const std::string &reason) {
+    function.degradation = degradations_.size();
+    degradations_.push_back(
+        {function_id, reason, function.calls - 1, last_call_rate_, calls_, 0});
+}
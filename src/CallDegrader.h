@@ -0,0 +1,136 @@
+#ifndef PROMISEDYNTRACER_CALL_DEGRADER_H
+#define PROMISEDYNTRACER_CALL_DEGRADER_H
+
+#include "stdlibs.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Switches hot closures over to a counters only mode. A closure is
+   switched over once it has been called more than the call limit, or when
+   the call rate of a window of calls exceeds the budget, in which case the
+   hottest closure of that window is switched over on its next call. The
+   calls of a switched over closure are transparent, like filtered calls,
+   and only counted. Every switch-over is recorded with its counters so
+   that the output can be corrected for the missing calls. */
+class CallDegrader {
+  public:
+    static constexpr std::uint64_t WINDOW_CALLS = 1 << 16;
+
+    struct degradation_t {
+        std::string function_id;
+        std::string reason;
+        /* calls of the closure traced before the switch-over */
+        std::uint64_t traced_calls;
+        /* calls per second of the last complete window */
+        double call_rate;
+        /* calls of all functions seen before the switch-over */
+        std::uint64_t calls;
+        std::uint64_t degraded_calls;
+    };
+
+    CallDegrader();
+
+    /* a limit or a rate of 0 disables that policy */
+    void configure(std::uint64_t call_limit, double call_rate);
+
+    bool is_enabled() const { return call_limit_ != 0 || call_rate_ != 0; }
+
+    /* counts a closure call, returns true if it is only counted. The
+       function id is only computed on a switch-over. */
+    template <typename FunctionId>
+    bool enter(const SEXP op, const FunctionId &function_id) {
+        if (!is_enabled())
+            return false;
+
+        tick_();
+
+        function_t &function = functions_[op];
+        if (function.degradation != NOT_DEGRADED) {
+            ++degradations_[function.degradation].degraded_calls;
+            return true;
+        }
+
+        ++function.calls;
+        if (function.window != window_) {
+            function.window = window_;
+            function.window_calls = 0;
+        }
+        if (++function.window_calls > hottest_calls_) {
+            hottest_ = op;
+            hottest_calls_ = function.window_calls;
+        }
+
+        if (call_limit_ != 0 && function.calls > call_limit_) {
+            degrade_(function, function_id(), "call_limit");
+        } else if (op == over_budget_) {
+            over_budget_ = nullptr;
+            degrade_(function, function_id(), "call_rate");
+        } else {
+            return false;
+        }
+
+        ++degradations_[function.degradation].degraded_calls;
+        return true;
+    }
+
+    bool is_degraded(const SEXP op) const {
+        if (!is_enabled())
+            return false;
+        auto iter = functions_.find(op);
+        return iter != functions_.end() &&
+               iter->second.degradation != NOT_DEGRADED;
+    }
+
+    /* builtin and special calls only count towards the call rate */
+    void count_call() {
+        if (is_enabled())
+            tick_();
+    }
+
+    /* the address of a collected closure can be reused by another one,
+       its degradation record is kept */
+    void remove(const SEXP function);
+
+    const std::vector<degradation_t> &get_degradations() const {
+        return degradations_;
+    }
+
+  private:
+    static constexpr int NOT_DEGRADED = -1;
+
+    struct function_t {
+        std::uint64_t calls = 0;
+        std::uint64_t window = 0;
+        std::uint64_t window_calls = 0;
+        int degradation = NOT_DEGRADED;
+    };
+
+    void tick_() {
+        ++calls_;
+        if (++window_calls_ == WINDOW_CALLS)
+            end_window_();
+    }
+
+    void end_window_();
+
+    void degrade_(function_t &function, const std::string &function_id,
+                  const std::string &reason);
+
+    std::uint64_t call_limit_;
+    double call_rate_;
+    std::unordered_map<SEXP, function_t> functions_;
+    std::vector<degradation_t> degradations_;
+    std::uint64_t calls_;
+    std::uint64_t window_;
+    std::uint64_t window_calls_;
+    std::chrono::steady_clock::time_point window_start_;
+    double last_call_rate_;
+    SEXP hottest_;
+    std::uint64_t hottest_calls_;
+    SEXP over_budget_;
+};
+
+#endif /* PROMISEDYNTRACER_CALL_DEGRADER_H */
@@ -0,0 +1,36 @@
+#include "CallFilter.h"
+#include "utilities.h"
+
+CallFilter::CallFilter() : enabled_{false}, filtered_calls_{0} {}
+
+void CallFilter::allow_namespace(const std::string &name) {
+    enabled_ = true;
+    allowed_namespaces_.insert(name);
+}
+
+void CallFilter::deny_namespace(const std::string &name) {
+    enabled_ = true;
+    denied_namespaces_.insert(name);
+}
+
+void CallFilter::allow_function(const SEXP function) {
+    enabled_ = true;
+    decisions_[function] = false;
+}
+
+void CallFilter::deny_function(const SEXP function) {
+    enabled_ = true;
+    decisions_[function] = true;
+}
+
+bool CallFilter::decide_(const SEXP op) const {
+    const char *name = (TYPEOF(op) == CLOSXP) ? get_ns_name(op) : "base";
+
+    if (name == nullptr)
+        return false;
+
+    if (!allowed_namespaces_.empty() && allowed_namespaces_.count(name) == 0)
+        return true;
+
+    return denied_namespaces_.count(name) > 0;
+}
@@ -0,0 +1,69 @@
+#ifndef PROMISEDYNTRACER_CALL_FILTER_H
+#define PROMISEDYNTRACER_CALL_FILTER_H
+
+#include "stdlibs.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+/* Decides which calls are filtered out by namespace and function
+   allow/deny lists. A filtered call is transparent: it pushes no frame and
+   reaches neither the recorder, the analyses nor the trace, while what
+   happens inside it, promise creation included, is traced as usual. The
+   listed functions are precomputed into the decision cache, which is keyed
+   by the function object, and the other functions are decided by their
+   namespace on their first call. Primitives belong to base. The namespace
+   lists do not apply to closures defined outside a namespace, those are
+   only filtered if they are denied explicitly. */
+class CallFilter {
+  public:
+    CallFilter();
+
+    void allow_namespace(const std::string &name);
+    void deny_namespace(const std::string &name);
+    void allow_function(const SEXP function);
+    void deny_function(const SEXP function);
+
+    bool is_filtered(const SEXP op) {
+        if (!enabled_)
+            return false;
+        /* the op of the NewBuiltin2 calls is a language object, which
+           could be collected and its address reused by a closure */
+        if (TYPEOF(op) != CLOSXP && TYPEOF(op) != BUILTINSXP &&
+            TYPEOF(op) != SPECIALSXP)
+            return false;
+        auto iter = decisions_.find(op);
+        if (iter != decisions_.end())
+            return iter->second;
+        return decisions_.emplace(op, decide_(op)).first->second;
+    }
+
+    /* same as is_filtered, but also counts the filtered call */
+    bool filter_entry(const SEXP op) {
+        bool filtered = is_filtered(op);
+        filtered_calls_ += filtered;
+        return filtered;
+    }
+
+    /* the address of a collected closure can be reused by another one */
+    void remove(const SEXP function) {
+        if (enabled_)
+            decisions_.erase(function);
+    }
+
+    bool is_enabled() const { return enabled_; }
+
+    std::uint64_t get_filtered_calls() const { return filtered_calls_; }
+
+  private:
+    bool decide_(const SEXP op) const;
+
+    bool enabled_;
+    std::unordered_set<std::string> allowed_namespaces_;
+    std::unordered_set<std::string> denied_namespaces_;
+    std::unordered_map<SEXP, bool> decisions_;
+    std::uint64_t filtered_calls_;
+};
+
+#endif /* PROMISEDYNTRACER_CALL_FILTER_H */
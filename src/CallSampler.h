@@ -0,0 +1,120 @@
+#ifndef PROMISEDYNTRACER_CALL_SAMPLER_H
+#define PROMISEDYNTRACER_CALL_SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+enum class sampling_mode_t { NONE = 0, TOP_LEVEL, FUNCTION, CALL };
+
+/* Decides which closure calls are traced. With a rate of N, one in N
+   top-level calls, the functions whose id hashes to a multiple of N or the
+   calls whose sequence number does are traced. The decisions only depend
+   on the program, so two runs with the same rate sample the same calls. A
+   sampled out call keeps its frames on the shadow stack, so that context
+   jumps unwind correctly, but nothing of its subtree reaches the recorder,
+   the analyses or the trace. The root is the stack index of the outermost
+   sampled out frame. */
+class CallSampler {
+  public:
+    static constexpr std::size_t NO_ROOT = SIZE_MAX;
+
+    CallSampler()
+        : mode_{sampling_mode_t::NONE}, rate_{1}, root_{NO_ROOT},
+          top_level_calls_{0}, calls_{0}, sampled_calls_{0},
+          skipped_calls_{0} {}
+
+    void configure(sampling_mode_t mode, std::uint64_t rate) {
+        mode_ = rate <= 1 ? sampling_mode_t::NONE : mode;
+        rate_ = mode_ == sampling_mode_t::NONE ? 1 : rate;
+    }
+
+    bool is_enabled() const { return mode_ != sampling_mode_t::NONE; }
+
+    bool is_sampled_out() const { return root_ != NO_ROOT; }
+
+    /* true if the frame at the given stack index belongs to the sampled
+       out subtree */
+    bool is_sampled_out(std::size_t index) const { return index >= root_; }
+
+    /* decides a closure call whose frame will be pushed at the given stack
+       index. The function id is only computed in function mode. The
+       sampled and skipped counts only cover the decided calls, in top-level
+       mode the calls nested in a traced top-level call are not counted. */
+    template <typename FunctionId>
+    bool sample(std::size_t index, bool top_level,
+                const FunctionId &function_id) {
+        bool traced = true;
+        switch (mode_) {
+            case sampling_mode_t::NONE:
+                return true;
+            case sampling_mode_t::TOP_LEVEL:
+                if (!top_level)
+                    return true;
+                traced = top_level_calls_++ % rate_ == 0;
+                break;
+            case sampling_mode_t::FUNCTION:
+                traced = std::hash<std::string>{}(function_id()) % rate_ == 0;
+                break;
+            case sampling_mode_t::CALL:
+                traced = mix_(++calls_) % rate_ == 0;
+                break;
+        }
+        if (traced) {
+            ++sampled_calls_;
+        } else {
+            ++skipped_calls_;
+            root_ = index;
+        }
+        return traced;
+    }
+
+    /* the subtree ends when its root frame is popped, by a return or by a
+       context jump */
+    void pop_to(std::size_t stack_size) {
+        if (stack_size <= root_)
+            root_ = NO_ROOT;
+    }
+
+    sampling_mode_t get_mode() const { return mode_; }
+
+    std::uint64_t get_rate() const { return rate_; }
+
+    std::uint64_t get_sampled_calls() const { return sampled_calls_; }
+
+    std::uint64_t get_skipped_calls() const { return skipped_calls_; }
+
+  private:
+    /* splitmix64 finalizer, sequence numbers are too regular to be used
+       modulo the rate directly */
+    static std::uint64_t mix_(std::uint64_t value) {
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    sampling_mode_t mode_;
+    std::uint64_t rate_;
+    std::size_t root_;
+    std::uint64_t top_level_calls_;
+    std::uint64_t calls_;
+    std::uint64_t sampled_calls_;
+    std::uint64_t skipped_calls_;
+};
+
+inline std::string sampling_mode_to_string(sampling_mode_t mode) {
+    switch (mode) {
+        case sampling_mode_t::NONE:
+            return "none";
+        case sampling_mode_t::TOP_LEVEL:
+            return "top_level";
+        case sampling_mode_t::FUNCTION:
+            return "function";
+        case sampling_mode_t::CALL:
+            return "call";
+    }
+    return "none";
+}
+
+#endif /* PROMISEDYNTRACER_CALL_SAMPLER_H */
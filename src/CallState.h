@@ -1,6 +1,7 @@
 #ifndef PROMISE_DYNTRACER_CALL_STATE_H
 #define PROMISE_DYNTRACER_CALL_STATE_H
 
+#include "ForceOrder.h"
 #include "ParameterUse.h"
 #include "State.h"
 #include "utilities.h"
@@ -11,13 +12,7 @@ class CallState {
                        std::size_t formal_parameter_count)
         : call_id_{call_id}, fn_id_{fn_id},
           formal_parameter_count_{formal_parameter_count},
-          parameter_uses_{formal_parameter_count}, order_{} {
-
-        /* INFO - Reserve size to 15 bytes to prevent repeated string
-         * allocations when forced arguments are added. This increases
-         * the memory requirement but should speed up the program. */
-        order_.reserve(15);
-    }
+          parameter_uses_{formal_parameter_count}, order_{} {}
 
     const call_id_t get_call_id() const { return call_id_; }
 
@@ -40,7 +35,7 @@ class CallState {
            do we add it to the order. This ensures that there is a single
            order entry for all elements of ... */
         if (!previous_forced_state)
-            order_.append("|").append(std::to_string(position));
+            order_.push_back(position);
     }
 
     void lookup(std::size_t position) { parameter_uses_[position].lookup(); }
@@ -57,14 +52,14 @@ class CallState {
         return parameter_uses_;
     }
 
-    const std::string &get_order() const { return order_; }
+    const ForceOrder &get_order() const { return order_; }
 
   private:
     fn_id_t fn_id_;
     call_id_t call_id_;
     std::size_t formal_parameter_count_;
     std::vector<ParameterUse> parameter_uses_;
-    std::string order_;
+    ForceOrder order_;
 };
 
 inline std::ostream &operator<<(std::ostream &os, const CallState &call_state) {
@@ -6,6 +6,7 @@
 #include "DebugSerializer.h"
 #include "State.h"
 #include "TraceSerializer.h"
+#include <cstdint>
 #include <string>
 
 class Context {
@@ -19,7 +20,19 @@ class Context {
           driver_(new AnalysisDriver(*state_, output_dir, truncate, binary,
                                      compression_level, analysis_switch)),
           debugger_(new DebugSerializer(verbose)), output_dir_{output_dir},
-          binary_{binary}, compression_level_{compression_level} {}
+          binary_{binary}, compression_level_{compression_level} {
+        state_->call_sampler.configure(analysis_switch.sampling_mode,
+                                       analysis_switch.sampling_rate);
+        /* the limit is validated by to_analysis_switch */
+        state_->call_degrader.configure(
+            static_cast<std::uint64_t>(analysis_switch.degradation_call_limit),
+            analysis_switch.degradation_call_rate);
+        state_->primitive_fast_path =
+            !enable_trace && !verbose && !driver_->needs_builtin_info();
+        state_->full_promise_type =
+            verbose || driver_->needs_full_promise_type();
+        state_->locations.enable(verbose || driver_->needs_locations());
+    }
 
     tracer_state_t &get_state() { return *state_; }
 
@@ -76,6 +76,14 @@ class DataTableStream : public Stream {
         return zstd_compression_stream_ != nullptr;
     }
 
+    /* bytes reserved by the buffers of the stream stack */
+    std::size_t get_buffer_capacity() const {
+        return buffer_stream_->get_capacity() +
+               (is_compression_enabled()
+                    ? zstd_compression_stream_->get_buffer_capacity()
+                    : 0);
+    }
+
     const std::string &get_filepath() const { return table_filepath_; }
 
     size_t get_column_count() const { return column_count_; }
@@ -155,4 +163,11 @@ class DataTableStream : public Stream {
     ZstdCompressionStream *zstd_compression_stream_;
 };
 
+/* creates a binary or a text table, the extension of the file is added to
+   the given path */
+DataTableStream *create_data_table(const std::string &table_filepath,
+                                   const std::vector<std::string> &column_names,
+                                   bool truncate, bool binary = true,
+                                   int compression_level = 0);
+
 #endif /* PROMISEDYNTRACER_DATA_TABLE_STREAM_H */
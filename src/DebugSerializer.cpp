@@ -85,8 +85,10 @@ string DebugSerializer::log_line(const builtin_info_t &info) {
          << " parent=" << log_line(info.parent_on_stack)
          << " parent_call_id=" << info.parent_call_id
          << " parent_prom_id=" << info.in_prom_id
-         << " definition_location=" << info.definition_location
-         << " callsite_location=" << info.callsite_location
+         << " definition_location="
+         << state->locations.get(info.definition_location_id)
+         << " callsite_location="
+         << state->locations.get(info.callsite_location_id)
          << " compiled=" << info.fn_compiled
          << " definition=" << info.fn_definition;
     return line.str();
@@ -101,8 +103,10 @@ string DebugSerializer::log_line(const closure_info_t &info) {
          << " parent=" << log_line(info.parent_on_stack)
          << " parent_call_id=" << info.parent_call_id
          << " parent_prom_id=" << info.in_prom_id
-         << " definition_location=" << info.definition_location
-         << " callsite_location=" << info.callsite_location
+         << " definition_location="
+         << state->locations.get(info.definition_location_id)
+         << " callsite_location="
+         << state->locations.get(info.callsite_location_id)
          << " compiled=" << info.fn_compiled
          << " definition=" << info.fn_definition;
     return line.str();
@@ -393,3 +397,5 @@ void DebugSerializer::setState(tracer_state_t *state) {
 }
 
 bool DebugSerializer::needsState() { return !(this->has_state); }
+
+bool DebugSerializer::is_verbose() const { return verbose; }
@@ -37,6 +37,8 @@ class DebugSerializer {
 
     bool needsState();
 
+    bool is_verbose() const;
+
   private:
     tracer_state_t *state;
     bool has_state;
@@ -0,0 +1,158 @@
+#ifndef PROMISEDYNTRACER_DENSE_ID_MAP_H
+#define PROMISEDYNTRACER_DENSE_ID_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/* Map from tracer ids to values. Promise, environment, variable and call
+   ids are handed out by increasing counters, so the values are stored in
+   fixed size chunks of a vector indexed by id and no hashing is needed.
+   Negative ids, which are given to foreign promises, are kept in a side
+   table. Absent ids read as the default value. If chunk reclamation is
+   enabled, a chunk is freed as soon as its last id is erased, so that
+   memory follows the ids which are still alive. */
+template <typename T> class DenseIdMap {
+  public:
+    using id_type = std::int64_t;
+
+    explicit DenseIdMap(const T &default_value = T(),
+                        bool reclaim_chunks = false)
+        : default_value_{default_value}, reclaim_chunks_{reclaim_chunks},
+          size_{0} {}
+
+    bool contains(id_type id) const {
+        if (id < 0) {
+            return negative_values_.find(id) != negative_values_.end();
+        }
+        const chunk_t *chunk = get_chunk_(id);
+        return chunk != nullptr && chunk->occupied[offset_(id)];
+    }
+
+    const T &get(id_type id) const {
+        if (id < 0) {
+            auto iter = negative_values_.find(id);
+            return iter == negative_values_.end() ? default_value_
+                                                  : iter->second;
+        }
+        const chunk_t *chunk = get_chunk_(id);
+        return chunk == nullptr ? default_value_ : chunk->values[offset_(id)];
+    }
+
+    void set(id_type id, const T &value) { (*this)[id] = value; }
+
+    /* inserts the default value if the id is absent */
+    T &operator[](id_type id) {
+        if (id < 0) {
+            auto result = negative_values_.insert({id, default_value_});
+            if (result.second) {
+                ++size_;
+            }
+            return result.first->second;
+        }
+        chunk_t &chunk = get_or_create_chunk_(id);
+        std::size_t offset = offset_(id);
+        if (!chunk.occupied[offset]) {
+            chunk.occupied[offset] = true;
+            ++chunk.count;
+            ++size_;
+        }
+        return chunk.values[offset];
+    }
+
+    bool erase(id_type id) {
+        if (id < 0) {
+            if (negative_values_.erase(id) == 0) {
+                return false;
+            }
+            --size_;
+            return true;
+        }
+        std::size_t index = index_(id);
+        if (index >= chunks_.size() || !chunks_[index]) {
+            return false;
+        }
+        chunk_t &chunk = *chunks_[index];
+        std::size_t offset = offset_(id);
+        if (!chunk.occupied[offset]) {
+            return false;
+        }
+        chunk.occupied[offset] = false;
+        chunk.values[offset] = default_value_;
+        --chunk.count;
+        --size_;
+        if (reclaim_chunks_ && chunk.count == 0) {
+            chunks_[index].reset();
+        }
+        return true;
+    }
+
+    void clear() {
+        chunks_.clear();
+        negative_values_.clear();
+        size_ = 0;
+    }
+
+    std::size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    /* approximate number of bytes reserved by the map */
+    std::size_t get_memory_size() const {
+        std::size_t bytes = chunks_.capacity() * sizeof(chunks_[0]);
+        for (const auto &chunk : chunks_) {
+            if (chunk) {
+                bytes += sizeof(chunk_t) + CHUNK_SIZE * sizeof(T) +
+                         CHUNK_SIZE / 8;
+            }
+        }
+        bytes += negative_values_.bucket_count() * sizeof(void *) +
+                 negative_values_.size() *
+                     (sizeof(std::pair<const id_type, T>) + 2 * sizeof(void *));
+        return bytes;
+    }
+
+  private:
+    static constexpr std::size_t CHUNK_BITS = 12;
+    static constexpr std::size_t CHUNK_SIZE = std::size_t{1} << CHUNK_BITS;
+
+    struct chunk_t {
+        explicit chunk_t(const T &default_value)
+            : values(CHUNK_SIZE, default_value), occupied(CHUNK_SIZE, false),
+              count{0} {}
+
+        std::vector<T> values;
+        std::vector<bool> occupied;
+        std::size_t count;
+    };
+
+    static std::size_t index_(id_type id) { return id >> CHUNK_BITS; }
+
+    static std::size_t offset_(id_type id) { return id & (CHUNK_SIZE - 1); }
+
+    const chunk_t *get_chunk_(id_type id) const {
+        std::size_t index = index_(id);
+        return index < chunks_.size() ? chunks_[index].get() : nullptr;
+    }
+
+    chunk_t &get_or_create_chunk_(id_type id) {
+        std::size_t index = index_(id);
+        if (index >= chunks_.size()) {
+            chunks_.resize(index + 1);
+        }
+        if (!chunks_[index]) {
+            chunks_[index].reset(new chunk_t(default_value_));
+        }
+        return *chunks_[index];
+    }
+
+    std::vector<std::unique_ptr<chunk_t>> chunks_;
+    std::unordered_map<id_type, T> negative_values_;
+    T default_value_;
+    bool reclaim_chunks_;
+    std::size_t size_;
+};
+
+#endif /* PROMISEDYNTRACER_DENSE_ID_MAP_H */
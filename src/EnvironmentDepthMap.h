@@ -0,0 +1,113 @@
+#ifndef PROMISEDYNTRACER_ENVIRONMENT_DEPTH_MAP_H
+#define PROMISEDYNTRACER_ENVIRONMENT_DEPTH_MAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Map from enclosing environments to the depth of their topmost call frame,
+   updated on every push and pop of a call frame. It is an open addressing
+   table with linear probing which only grows, so once it holds as many
+   slots as the deepest stack needs, pushing and popping frames does not
+   allocate. Erasing shifts the following entries back instead of leaving
+   tombstones, so lookups never slow down as frames come and go. */
+class EnvironmentDepthMap {
+  public:
+    using environment_type = std::uintptr_t;
+
+    EnvironmentDepthMap() : size_{0} {}
+
+    /* returns the depth of the environment, -1 if it has none */
+    int get(environment_type environment) const {
+        return slots_.empty() ? -1 : slots_[find_slot_(environment)].depth;
+    }
+
+    /* sets the depth of the environment and returns its previous depth, -1
+       if it had none */
+    int exchange(environment_type environment, int depth) {
+        if (2 * (size_ + 1) > slots_.size())
+            grow_();
+        slot_t &slot = slots_[find_slot_(environment)];
+        int previous_depth = slot.depth;
+        if (previous_depth == -1) {
+            slot.environment = environment;
+            ++size_;
+        }
+        slot.depth = depth;
+        return previous_depth;
+    }
+
+    void erase(environment_type environment) {
+        if (slots_.empty())
+            return;
+        std::size_t mask = slots_.size() - 1;
+        std::size_t hole = find_slot_(environment);
+        if (slots_[hole].depth == -1)
+            return;
+        --size_;
+        /* an entry moves back into the hole unless its home slot lies
+           between the hole and the entry */
+        for (std::size_t index = (hole + 1) & mask; slots_[index].depth != -1;
+             index = (index + 1) & mask) {
+            std::size_t home = hash_(slots_[index].environment) & mask;
+            if (((index - home) & mask) >= ((index - hole) & mask)) {
+                slots_[hole] = slots_[index];
+                hole = index;
+            }
+        }
+        slots_[hole].depth = -1;
+    }
+
+    /* keeps the slots, so that the next pass does not allocate them again */
+    void clear() {
+        for (slot_t &slot : slots_)
+            slot.depth = -1;
+        size_ = 0;
+    }
+
+    std::size_t size() const { return size_; }
+
+    std::size_t get_memory_size() const {
+        return slots_.capacity() * sizeof(slot_t);
+    }
+
+  private:
+    static constexpr std::size_t MINIMUM_SLOT_COUNT = 64;
+
+    struct slot_t {
+        environment_type environment;
+        int depth;
+    };
+
+    /* environments are aligned addresses, the multiplication moves their
+       varying bits into the low bits used by the mask */
+    static std::size_t hash_(environment_type environment) {
+        std::uint64_t hash = environment * UINT64_C(0x9e3779b97f4a7c15);
+        return hash ^ (hash >> 32);
+    }
+
+    std::size_t find_slot_(environment_type environment) const {
+        std::size_t mask = slots_.size() - 1;
+        std::size_t index = hash_(environment) & mask;
+        while (slots_[index].depth != -1 &&
+               slots_[index].environment != environment)
+            index = (index + 1) & mask;
+        return index;
+    }
+
+    void grow_() {
+        std::vector<slot_t> slots(
+            std::max(MINIMUM_SLOT_COUNT, 2 * slots_.size()), slot_t{0, -1});
+        slots.swap(slots_);
+        for (const slot_t &slot : slots) {
+            if (slot.depth != -1)
+                slots_[find_slot_(slot.environment)] = slot;
+        }
+    }
+
+    std::vector<slot_t> slots_;
+    std::size_t size_;
+};
+
+#endif /* PROMISEDYNTRACER_ENVIRONMENT_DEPTH_MAP_H */
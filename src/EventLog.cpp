@@ -0,0 +1,400 @@
+#include "EventLog.h"
+#include "utilities.h"
+
+const char EventLog::MAGIC[8] = {'P', 'D', 'T', 'E', 'V', 'L', 'O', 'G'};
+const std::uint32_t EventLog::VERSION = 2;
+
+static const std::size_t EVENT_LOG_BUFFER_SIZE = 4 * 1024 * 1024;
+
+EventLog::EventLog(const std::string &filepath, int compression_level)
+    : file_stream_{nullptr}, buffer_stream_{nullptr},
+      compression_stream_{nullptr}, sink_{nullptr} {
+
+    /* a log is a single recording, appending to an older one would make it
+       unreadable, so it is always truncated. */
+    file_stream_ = new FileStream(filepath, O_WRONLY | O_CREAT | O_TRUNC);
+    buffer_stream_ = new BufferStream(file_stream_, EVENT_LOG_BUFFER_SIZE);
+
+    if (compression_level > 0) {
+        compression_stream_ =
+            new ZstdCompressionStream(buffer_stream_, compression_level);
+        sink_ = compression_stream_;
+    } else {
+        sink_ = buffer_stream_;
+    }
+
+    sink_->write(MAGIC, sizeof(MAGIC));
+    write_(VERSION);
+}
+
+EventLog::~EventLog() {
+    delete compression_stream_;
+    delete buffer_stream_;
+    delete file_stream_;
+}
+
+void EventLog::write_string_(const std::string &value) {
+    write_(static_cast<std::uint32_t>(value.size()));
+    sink_->write(value.data(), value.size());
+}
+
+void EventLog::write_symbol_(const std::string &value) {
+    auto result = symbols_.insert({value, symbols_.size()});
+    write_(result.first->second);
+    if (result.second) {
+        write_string_(value);
+    }
+}
+
+void EventLog::write_stack_event_(const stack_event_t &event) {
+    write_(static_cast<std::uint8_t>(event.type));
+    write_(static_cast<std::uint64_t>(event.call_id));
+    write_(static_cast<std::uint64_t>(event.enclosing_environment));
+    if (event.type == stack_type::CALL) {
+        /* the parent frames of infos do not record their function */
+        static const std::string no_function_id;
+        write_symbol_(event.function_info.function_id == nullptr
+                          ? no_function_id
+                          : *event.function_info.function_id);
+        write_(static_cast<std::uint8_t>(event.function_info.type));
+    }
+}
+
+void EventLog::write_call_info_(EventType type, const call_info_t &info) {
+    write_(type);
+    write_(static_cast<std::uint8_t>(info.fn_type));
+    write_symbol_(info.fn_id);
+    write_(get_sexp_address(info.fn_addr));
+    write_symbol_(info.fn_definition);
+    write_(static_cast<std::int32_t>(info.definition_location_id));
+    write_(static_cast<std::int32_t>(info.callsite_location_id));
+    write_(static_cast<std::uint8_t>(info.fn_compiled));
+    write_symbol_(info.name);
+    write_(static_cast<std::uint64_t>(info.call_id));
+    write_(static_cast<std::uint64_t>(info.call_ptr));
+    write_(static_cast<std::uint64_t>(info.parent_call_id));
+    write_(static_cast<std::int64_t>(info.in_prom_id));
+    write_stack_event_(info.parent_on_stack);
+    write_(static_cast<std::uint32_t>(info.return_value_type));
+    write_string_(info.call_expression);
+    write_(static_cast<std::int32_t>(info.formal_parameter_count));
+}
+
+void EventLog::call(EventType type, const closure_info_t &info) {
+    write_call_info_(type, info);
+    write_(static_cast<std::uint32_t>(info.arguments.size()));
+    for (const arg_t &argument : info.arguments) {
+        write_(static_cast<std::uint64_t>(argument.id));
+        write_symbol_(argument.name);
+        write_(static_cast<std::uint32_t>(argument.value_type));
+        write_(static_cast<std::uint32_t>(argument.name_type));
+        write_(static_cast<std::int64_t>(argument.promise_id));
+        write_(get_sexp_address(argument.promise_environment));
+        write_(static_cast<std::uint8_t>(argument.parameter_mode));
+        write_(static_cast<std::int32_t>(argument.formal_parameter_position));
+    }
+}
+
+void EventLog::call(EventType type, const builtin_info_t &info) {
+    write_call_info_(type, info);
+}
+
+void EventLog::write_prom_basic_info_(EventType type,
+                                      const prom_basic_info_t &info,
+                                      const SEXP promise) {
+    write_(type);
+    write_(get_sexp_address(promise));
+    write_(static_cast<std::int64_t>(info.prom_id));
+    write_(get_sexp_address(info.promise_environment));
+    write_(static_cast<std::uint32_t>(info.prom_type));
+    write_(static_cast<std::uint32_t>(info.full_type.size()));
+    for (sexptype_t sexptype : info.full_type) {
+        write_(static_cast<std::uint32_t>(sexptype));
+    }
+    write_(static_cast<std::int64_t>(info.in_prom_id));
+    write_stack_event_(info.parent_on_stack);
+    write_(static_cast<std::int32_t>(info.depth));
+    write_symbol_(info.expression);
+}
+
+void EventLog::promise(EventType type, const prom_basic_info_t &info,
+                       const SEXP promise) {
+    write_prom_basic_info_(type, info, promise);
+}
+
+void EventLog::promise(EventType type, const prom_info_t &info,
+                       const SEXP promise) {
+    write_prom_basic_info_(type, info, promise);
+    write_(static_cast<std::uint64_t>(info.in_call_id));
+    write_(static_cast<std::uint64_t>(info.from_call_id));
+    write_(static_cast<std::uint32_t>(info.return_type));
+}
+
+void EventLog::gc_promise_unmarked(const prom_id_t prom_id,
+                                   const SEXP promise) {
+    write_(EventType::GC_PROMISE_UNMARKED);
+    write_(get_sexp_address(promise));
+    write_(static_cast<std::int64_t>(prom_id));
+}
+
+void EventLog::gc_environment_unmarked(const SEXP rho) {
+    write_(EventType::GC_ENVIRONMENT_UNMARKED);
+    write_(get_sexp_address(rho));
+}
+
+void EventLog::gc_exit(const gc_info_t &info) {
+    write_(EventType::GC_EXIT);
+    write_(static_cast<std::int32_t>(info.counter));
+}
+
+void EventLog::vector_alloc(const type_gc_info_t &info) {
+    write_(EventType::VECTOR_ALLOC);
+    write_(static_cast<std::int32_t>(info.gc_trigger_counter));
+    write_(static_cast<std::int32_t>(info.type));
+    write_(static_cast<std::int64_t>(info.length));
+    write_(static_cast<std::int64_t>(info.bytes));
+}
+
+void EventLog::environment_action(EventType type, const SEXP symbol,
+                                  const SEXP value, const SEXP rho) {
+    write_(type);
+    write_symbol_(CHAR(PRINTNAME(symbol)));
+    write_(get_sexp_address(value));
+    write_(static_cast<std::uint32_t>(value == nullptr ? NILSXP
+                                                       : TYPEOF(value)));
+    write_(get_sexp_address(rho));
+}
+
+void EventLog::context_jump(const unwind_info_t &info) {
+    write_(EventType::CONTEXT_JUMP);
+    write_(static_cast<std::uint64_t>(info.jump_context));
+    write_(static_cast<std::int32_t>(info.restart));
+    write_(static_cast<std::uint32_t>(info.unwound_frames.size()));
+    for (const stack_event_t &event : info.unwound_frames) {
+        write_stack_event_(event);
+    }
+}
+
+void EventLog::end() {
+    write_(EventType::END);
+    if (compression_stream_ != nullptr) {
+        compression_stream_->finalize();
+    }
+    buffer_stream_->flush();
+}
+
+EventLogReader::EventLogReader(const std::string &filepath)
+    : filepath_{filepath}, data_{nullptr}, size_{0},
+      decompression_stream_{nullptr}, input_{nullptr, 0, 0},
+      current_{nullptr}, limit_{nullptr} {
+
+    std::tie(data_, size_) = map_to_memory(filepath);
+
+    bool compressed = filepath.size() >= 4 &&
+                      filepath.compare(filepath.size() - 4, 4, ".zst") == 0;
+
+    if (compressed) {
+        decompression_stream_ = ZSTD_createDStream();
+        if (decompression_stream_ == NULL) {
+            fprintf(stderr, "ZSTD_createDStream() error \n");
+            exit(EXIT_FAILURE);
+        }
+        ZSTD_initDStream(decompression_stream_);
+        input_ = {data_, size_, 0};
+        buffer_.resize(ZSTD_DStreamOutSize());
+    } else {
+        current_ = static_cast<const char *>(data_);
+        limit_ = current_ + size_;
+    }
+
+    char magic[sizeof(EventLog::MAGIC)];
+    read_bytes_(magic, sizeof(magic));
+    std::uint32_t version = read_<std::uint32_t>();
+    if (std::memcmp(magic, EventLog::MAGIC, sizeof(magic)) != 0 ||
+        version != EventLog::VERSION) {
+        fprintf(stderr, "%s is not an event log of version %u\n",
+                filepath.c_str(), EventLog::VERSION);
+        exit(EXIT_FAILURE);
+    }
+}
+
+EventLogReader::~EventLogReader() {
+    if (decompression_stream_ != nullptr) {
+        ZSTD_freeDStream(decompression_stream_);
+    }
+    if (data_ != nullptr) {
+        unmap_memory(data_, size_);
+    }
+}
+
+bool EventLogReader::fill_() {
+    if (decompression_stream_ == nullptr) {
+        return false;
+    }
+    ZSTD_outBuffer output{buffer_.data(), buffer_.size(), 0};
+    while (output.pos == 0 && input_.pos < input_.size) {
+        std::size_t result =
+            ZSTD_decompressStream(decompression_stream_, &output, &input_);
+        if (ZSTD_isError(result)) {
+            fprintf(stderr, "ZSTD_decompressStream() error : %s \n",
+                    ZSTD_getErrorName(result));
+            exit(EXIT_FAILURE);
+        }
+    }
+    current_ = buffer_.data();
+    limit_ = current_ + output.pos;
+    return output.pos != 0;
+}
+
+void EventLogReader::read_bytes_(void *destination, std::size_t bytes) {
+    char *dest = static_cast<char *>(destination);
+    while (bytes != 0) {
+        if (current_ == limit_ && !fill_()) {
+            fprintf(stderr, "unexpected end of event log %s\n",
+                    filepath_.c_str());
+            exit(EXIT_FAILURE);
+        }
+        std::size_t copied_bytes =
+            std::min<std::size_t>(limit_ - current_, bytes);
+        std::memcpy(dest, current_, copied_bytes);
+        current_ += copied_bytes;
+        dest += copied_bytes;
+        bytes -= copied_bytes;
+    }
+}
+
+bool EventLogReader::next(EventType &type) {
+    if (current_ == limit_ && !fill_()) {
+        return false;
+    }
+    type = read_<EventType>();
+    return true;
+}
+
+std::string EventLogReader::read_string_() {
+    std::uint32_t size = read_<std::uint32_t>();
+    std::string value(size, '\0');
+    read_bytes_(&value[0], size);
+    return value;
+}
+
+const std::string &EventLogReader::read_symbol_() {
+    std::uint32_t handle = read_<std::uint32_t>();
+    if (handle == symbols_.size()) {
+        symbols_.push_back(read_string_());
+    }
+    return symbols_[handle];
+}
+
+void EventLogReader::read_stack_event_(stack_event_t &event) {
+    event.type = static_cast<stack_type>(read_<std::uint8_t>());
+    event.call_id = read_<std::uint64_t>();
+    event.enclosing_environment = read_<std::uint64_t>();
+    if (event.type == stack_type::CALL) {
+        event.function_info.function_id = &read_symbol_();
+        event.function_info.type =
+            static_cast<function_type>(read_<std::uint8_t>());
+    }
+}
+
+void EventLogReader::read_call_info_(call_info_t &info) {
+    info.fn_type = static_cast<function_type>(read_<std::uint8_t>());
+    info.interned_fn_id = &read_symbol_();
+    info.fn_id = *info.interned_fn_id;
+    info.fn_addr = read_sexp_();
+    info.fn_definition = read_symbol_();
+    info.definition_location_id = read_<std::int32_t>();
+    info.callsite_location_id = read_<std::int32_t>();
+    info.fn_compiled = read_<std::uint8_t>();
+    info.name = read_symbol_();
+    info.call_id = read_<std::uint64_t>();
+    info.call_ptr = read_<std::uint64_t>();
+    info.parent_call_id = read_<std::uint64_t>();
+    info.in_prom_id = read_<std::int64_t>();
+    read_stack_event_(info.parent_on_stack);
+    info.return_value_type = read_<std::uint32_t>();
+    info.call_expression = read_string_();
+    info.formal_parameter_count = read_<std::int32_t>();
+}
+
+void EventLogReader::read(closure_info_t &info) {
+    read_call_info_(info);
+    info.arguments.resize(read_<std::uint32_t>());
+    for (arg_t &argument : info.arguments) {
+        argument.id = read_<std::uint64_t>();
+        argument.name = read_symbol_();
+        argument.value_type = read_<std::uint32_t>();
+        argument.name_type = read_<std::uint32_t>();
+        argument.promise_id = read_<std::int64_t>();
+        argument.promise_environment = read_sexp_();
+        argument.parameter_mode =
+            static_cast<parameter_mode_t>(read_<std::uint8_t>());
+        argument.formal_parameter_position = read_<std::int32_t>();
+    }
+}
+
+void EventLogReader::read(builtin_info_t &info) { read_call_info_(info); }
+
+void EventLogReader::read_prom_basic_info_(prom_basic_info_t &info,
+                                           SEXP &promise) {
+    promise = read_sexp_();
+    info.prom_id = read_<std::int64_t>();
+    info.promise_environment = read_sexp_();
+    info.prom_type = read_<std::uint32_t>();
+    info.full_type.resize(read_<std::uint32_t>());
+    for (sexptype_t &sexptype : info.full_type) {
+        sexptype = read_<std::uint32_t>();
+    }
+    info.in_prom_id = read_<std::int64_t>();
+    read_stack_event_(info.parent_on_stack);
+    info.depth = read_<std::int32_t>();
+    info.expression = read_symbol_();
+}
+
+void EventLogReader::read(prom_basic_info_t &info, SEXP &promise) {
+    read_prom_basic_info_(info, promise);
+}
+
+void EventLogReader::read(prom_info_t &info, SEXP &promise) {
+    read_prom_basic_info_(info, promise);
+    info.in_call_id = read_<std::uint64_t>();
+    info.from_call_id = read_<std::uint64_t>();
+    info.return_type = read_<std::uint32_t>();
+}
+
+void EventLogReader::read_gc_promise_unmarked(prom_id_t &prom_id,
+                                              SEXP &promise) {
+    promise = read_sexp_();
+    prom_id = read_<std::int64_t>();
+}
+
+void EventLogReader::read_gc_environment_unmarked(SEXP &rho) {
+    rho = read_sexp_();
+}
+
+void EventLogReader::read(gc_info_t &info) {
+    info.counter = read_<std::int32_t>();
+}
+
+void EventLogReader::read(type_gc_info_t &info) {
+    info.gc_trigger_counter = read_<std::int32_t>();
+    info.type = read_<std::int32_t>();
+    info.length = read_<std::int64_t>();
+    info.bytes = read_<std::int64_t>();
+}
+
+void EventLogReader::read(environment_action_t &action) {
+    action.symbol = read_symbol_();
+    action.value = read_<std::uint64_t>();
+    action.value_type = read_<std::uint32_t>();
+    action.rho = read_<std::uint64_t>();
+}
+
+void EventLogReader::read(unwind_info_t &info) {
+    info.jump_context = read_<std::uint64_t>();
+    info.restart = read_<std::int32_t>();
+    info.unwound_frames.resize(read_<std::uint32_t>());
+    for (stack_event_t &event : info.unwound_frames) {
+        read_stack_event_(event);
+    }
+}
@@ -0,0 +1,158 @@
+#ifndef PROMISEDYNTRACER_EVENT_LOG_H
+#define PROMISEDYNTRACER_EVENT_LOG_H
+
+#include "BufferStream.h"
+#include "FileStream.h"
+#include "State.h"
+#include "ZstdCompressionStream.h"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Events received by the AnalysisDriver, in the order in which they were
+   received. Every record is a one byte tag followed by the fields of the
+   info structures passed with the event. SEXP arguments are recorded as
+   addresses together with the facts the analyses read from them, so that
+   the log can be replayed without R. Function ids, names and definitions
+   are interned: a string is written in full the first time and by its
+   handle afterwards. Locations are written as the ids of the locations
+   table. */
+enum class EventType : std::uint8_t {
+    CLOSURE_ENTRY = 0,
+    CLOSURE_EXIT,
+    SPECIAL_ENTRY,
+    SPECIAL_EXIT,
+    BUILTIN_ENTRY,
+    BUILTIN_EXIT,
+    PROMISE_CREATED,
+    PROMISE_FORCE_ENTRY,
+    PROMISE_FORCE_EXIT,
+    PROMISE_ENVIRONMENT_LOOKUP,
+    PROMISE_EXPRESSION_LOOKUP,
+    PROMISE_VALUE_LOOKUP,
+    PROMISE_ENVIRONMENT_SET,
+    PROMISE_EXPRESSION_SET,
+    PROMISE_VALUE_SET,
+    GC_PROMISE_UNMARKED,
+    GC_ENVIRONMENT_UNMARKED,
+    GC_EXIT,
+    VECTOR_ALLOC,
+    ENVIRONMENT_DEFINE_VAR,
+    ENVIRONMENT_ASSIGN_VAR,
+    ENVIRONMENT_LOOKUP_VAR,
+    ENVIRONMENT_REMOVE_VAR,
+    CONTEXT_JUMP,
+    END
+};
+
+/* variable action as seen by the driver, the symbol and the value are
+   reduced to the name and the type. */
+struct environment_action_t {
+    std::string symbol;
+    std::uint64_t value;
+    sexptype_t value_type;
+    std::uint64_t rho;
+};
+
+class EventLog {
+  public:
+    static const char MAGIC[8];
+    static const std::uint32_t VERSION;
+
+    EventLog(const std::string &filepath, int compression_level);
+
+    ~EventLog();
+
+    void call(EventType type, const closure_info_t &info);
+    void call(EventType type, const builtin_info_t &info);
+    void promise(EventType type, const prom_basic_info_t &info,
+                 const SEXP promise);
+    void promise(EventType type, const prom_info_t &info, const SEXP promise);
+    void gc_promise_unmarked(const prom_id_t prom_id, const SEXP promise);
+    void gc_environment_unmarked(const SEXP rho);
+    void gc_exit(const gc_info_t &info);
+    void vector_alloc(const type_gc_info_t &info);
+    void environment_action(EventType type, const SEXP symbol,
+                            const SEXP value, const SEXP rho);
+    void context_jump(const unwind_info_t &info);
+    void end();
+
+  private:
+    template <typename T> void write_(const T &value) {
+        sink_->write(&value, sizeof(value));
+    }
+
+    void write_string_(const std::string &value);
+    void write_symbol_(const std::string &value);
+    void write_stack_event_(const stack_event_t &event);
+    void write_call_info_(EventType type, const call_info_t &info);
+    void write_prom_basic_info_(EventType type, const prom_basic_info_t &info,
+                                const SEXP promise);
+
+    FileStream *file_stream_;
+    BufferStream *buffer_stream_;
+    ZstdCompressionStream *compression_stream_;
+    Stream *sink_;
+    std::unordered_map<std::string, std::uint32_t> symbols_;
+};
+
+/* Reads an event log written by EventLog, decompressing it on the fly if
+   the file name ends in .zst. */
+class EventLogReader {
+  public:
+    explicit EventLogReader(const std::string &filepath);
+
+    ~EventLogReader();
+
+    const std::string &get_filepath() const { return filepath_; }
+
+    /* false once the end of the log has been reached */
+    bool next(EventType &type);
+
+    void read(closure_info_t &info);
+    void read(builtin_info_t &info);
+    void read(prom_basic_info_t &info, SEXP &promise);
+    void read(prom_info_t &info, SEXP &promise);
+    void read_gc_promise_unmarked(prom_id_t &prom_id, SEXP &promise);
+    void read_gc_environment_unmarked(SEXP &rho);
+    void read(gc_info_t &info);
+    void read(type_gc_info_t &info);
+    void read(environment_action_t &action);
+    void read(unwind_info_t &info);
+
+  private:
+    template <typename T> T read_() {
+        T value;
+        read_bytes_(&value, sizeof(value));
+        return value;
+    }
+
+    SEXP read_sexp_() {
+        return reinterpret_cast<SEXP>(read_<std::uint64_t>());
+    }
+
+    void read_bytes_(void *destination, std::size_t bytes);
+    bool fill_();
+    std::string read_string_();
+    const std::string &read_symbol_();
+    void read_stack_event_(stack_event_t &event);
+    void read_call_info_(call_info_t &info);
+    void read_prom_basic_info_(prom_basic_info_t &info, SEXP &promise);
+
+    std::string filepath_;
+    void *data_;
+    std::size_t size_;
+    ZSTD_DStream *decompression_stream_;
+    ZSTD_inBuffer input_;
+    std::vector<char> buffer_;
+    /* unread part of the mapped file or of the decompressed buffer */
+    const char *current_;
+    const char *limit_;
+    /* a deque, so that the frames read from the log can point to their
+       function ids */
+    std::deque<std::string> symbols_;
+};
+
+#endif /* PROMISEDYNTRACER_EVENT_LOG_H */
@@ -1,4 +1,9 @@
 #include "FileStream.h"
+#include <fstream>
+
+bool file_exists(const std::string &filepath) {
+    return std::ifstream(filepath).good();
+}
 
 int open_file(const std::string &filepath, int flags, mode_t mode) {
     int fd;
@@ -16,6 +16,7 @@
 #include <utility>
 #include <zstd.h>
 
+bool file_exists(const std::string &filepath);
 int open_file(const std::string &filepath, int flags, mode_t mode = 0666);
 void close_file(int fd, const std::string &filepath);
 std::pair<void *, std::size_t> map_to_memory(const std::string &filepath);
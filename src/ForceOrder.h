@@ -0,0 +1,85 @@
+#ifndef PROMISE_DYNTRACER_FORCE_ORDER_H
+#define PROMISE_DYNTRACER_FORCE_ORDER_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/* Sequence of formal parameter positions in the order in which they were
+   forced. Most calls force only a handful of arguments, so the first
+   positions are stored inline and only longer orders spill over to the
+   heap. The string representation is only built for serialization. */
+class ForceOrder {
+  public:
+    using position_t = std::uint16_t;
+
+    ForceOrder() : size_{0}, inline_positions_{} {}
+
+    void push_back(std::size_t position) {
+        if (size_ < INLINE_CAPACITY) {
+            inline_positions_[size_] = static_cast<position_t>(position);
+        } else {
+            overflow_positions_.push_back(static_cast<position_t>(position));
+        }
+        ++size_;
+    }
+
+    std::size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    position_t operator[](std::size_t index) const {
+        return index < INLINE_CAPACITY
+                   ? inline_positions_[index]
+                   : overflow_positions_[index - INLINE_CAPACITY];
+    }
+
+    bool operator==(const ForceOrder &other) const {
+        if (size_ != other.size_)
+            return false;
+        std::size_t inline_size = std::min<std::size_t>(size_, INLINE_CAPACITY);
+        return std::equal(inline_positions_.begin(),
+                          inline_positions_.begin() + inline_size,
+                          other.inline_positions_.begin()) &&
+               overflow_positions_ == other.overflow_positions_;
+    }
+
+    bool operator!=(const ForceOrder &other) const { return !(*this == other); }
+
+    /* FNV-1a over the positions */
+    std::size_t hash() const {
+        std::size_t value = 14695981039346656037ULL;
+        for (std::size_t index = 0; index < size_; ++index) {
+            value ^= (*this)[index];
+            value *= 1099511628211ULL;
+        }
+        return value;
+    }
+
+    std::string to_string() const {
+        std::string order;
+        for (std::size_t index = 0; index < size_; ++index) {
+            order.append("|").append(std::to_string((*this)[index]));
+        }
+        return order;
+    }
+
+  private:
+    static constexpr std::size_t INLINE_CAPACITY = 14;
+    std::uint32_t size_;
+    std::array<position_t, INLINE_CAPACITY> inline_positions_;
+    std::vector<position_t> overflow_positions_;
+};
+
+namespace std {
+template <> struct hash<ForceOrder> {
+    std::size_t operator()(const ForceOrder &order) const {
+        return order.hash();
+    }
+};
+} // namespace std
+
+#endif /* PROMISE_DYNTRACER_FORCE_ORDER_H */
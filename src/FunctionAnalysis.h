@@ -1,108 +1,195 @@
 #ifndef PROMISE_DYNTRACER_FUNCTION_ANALYSIS_H
 #define PROMISE_DYNTRACER_FUNCTION_ANALYSIS_H
 
+#include "FunctionBodyPack.h"
+#include "MemoryAccount.h"
 #include "State.h"
 #include "Timer.h"
+#include "table.h"
 #include "utilities.h"
 
 class FunctionAnalysis {
   public:
+    /* One row of the functions table. The function id and the call name are
+       interned to integer handles on entry so that neither the call stack
+       nor the aggregation table hold any heap allocated strings. */
+    struct function_key_t {
+        int function_handle;
+        int name_handle;
+        int formal_parameter_count;
+        sexptype_t type;
+        sexptype_t return_value_type;
+
+        bool operator==(const function_key_t &other) const {
+            return function_handle == other.function_handle &&
+                   name_handle == other.name_handle &&
+                   formal_parameter_count == other.formal_parameter_count &&
+                   type == other.type &&
+                   return_value_type == other.return_value_type;
+        }
+    };
+
+    struct function_key_hash_t {
+        std::size_t operator()(const function_key_t &key) const {
+            std::size_t seed = key.function_handle;
+            auto combine = [&seed](std::size_t value) {
+                seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            };
+            combine(key.name_handle);
+            combine(key.formal_parameter_count);
+            combine(key.type);
+            combine(key.return_value_type);
+            return seed;
+        }
+    };
+
     FunctionAnalysis(const tracer_state_t &tracer_state,
-                     const std::string &output_dir)
-        : tracer_state_{tracer_state}, output_dir_{output_dir},
-          closure_type_{sexptype_to_string(CLOSXP)},
-          builtin_type_{sexptype_to_string(BUILTINSXP)},
-          special_type_{sexptype_to_string(SPECIALSXP)} {}
+                     const std::string &output_dir, bool truncate, bool binary,
+                     int compression_level)
+        : tracer_state_{tracer_state}, output_dir_{output_dir} {
+
+        functions_data_table_ = create_data_table(
+            output_dir + "/" + "functions",
+            {"id", "type", "arguments", "name", "return_type", "calls"},
+            truncate, binary, compression_level);
+
+        function_body_pack_ = new FunctionBodyPack(
+            output_dir + "/" + "functions.pack",
+            output_dir + "/" + "functions.index", truncate, compression_level);
+    }
 
     void closure_entry(const closure_info_t &closure_info) {
-        push_function_(closure_info.fn_id, closure_type_,
-                       closure_info.formal_parameter_count, closure_info.name);
-        write_function_body_(closure_info.fn_id, closure_info.fn_definition);
+        push_function_(closure_info.fn_id, CLOSXP,
+                       closure_info.formal_parameter_count, closure_info.name,
+                       closure_info.fn_definition);
     }
 
     void special_entry(const builtin_info_t &special_info) {
-        push_function_(special_info.fn_id, special_type_,
-                       special_info.formal_parameter_count, special_info.name);
-        write_function_body_(special_info.fn_id, special_info.fn_definition);
+        push_function_(special_info.fn_id, SPECIALSXP,
+                       special_info.formal_parameter_count, special_info.name,
+                       special_info.fn_definition);
     }
 
     void builtin_entry(const builtin_info_t &builtin_info) {
-        push_function_(builtin_info.fn_id, builtin_type_,
-                       builtin_info.formal_parameter_count, builtin_info.name);
-        write_function_body_(builtin_info.fn_id, builtin_info.fn_definition);
+        push_function_(builtin_info.fn_id, BUILTINSXP,
+                       builtin_info.formal_parameter_count, builtin_info.name,
+                       builtin_info.fn_definition);
     }
 
     void closure_exit(const closure_info_t &closure_info) {
-        pop_function_(sexptype_to_string(closure_info.return_value_type));
+        pop_function_(closure_info.return_value_type);
     }
 
     void special_exit(const builtin_info_t &special_info) {
-        pop_function_(sexptype_to_string(special_info.return_value_type));
+        pop_function_(special_info.return_value_type);
     }
 
     void builtin_exit(const builtin_info_t &builtin_info) {
-        pop_function_(sexptype_to_string(builtin_info.return_value_type));
+        pop_function_(builtin_info.return_value_type);
     }
 
-    void end(dyntracer_t *dyntracer) { serialize(); }
+    void end(dyntracer_t *dyntracer) {
+        serialize();
+        function_body_pack_->flush();
+    }
 
     void context_jump(const unwind_info_t &info) {
         for (auto &element : info.unwound_frames) {
             if (element.type == stack_type::CALL)
-                pop_function_("Unknown (Jumped)");
+                pop_function_(JUMPSXP);
         }
     }
 
-  private:
-    void serialize() {
-        std::ofstream function_writer_{output_dir_ + "/functions.csv"};
+    void account_memory(MemoryAccount &account) const {
+        account.add("function_analysis/functions", functions_.size(),
+                    approximate_memory_size(functions_));
+        account.add("function_analysis/function_stack", function_stack_.size(),
+                    approximate_memory_size(function_stack_));
+        std::size_t handle_bytes = approximate_memory_size(function_handles_) +
+                                   approximate_memory_size(function_ids_) +
+                                   approximate_memory_size(name_handles_) +
+                                   approximate_memory_size(names_);
+        for (const auto &function_id : function_ids_) {
+            handle_bytes += 2 * approximate_memory_size(function_id);
+        }
+        for (const auto &name : names_) {
+            handle_bytes += 2 * approximate_memory_size(name);
+        }
+        account.add("function_analysis/handles",
+                    function_ids_.size() + names_.size(), handle_bytes);
+        account.add_table("function_analysis/functions-table",
+                          functions_data_table_);
+    }
 
-        function_writer_ << "id , type , arguments , name , return_type , calls"
-                         << std::endl;
+    ~FunctionAnalysis() {
+        delete functions_data_table_;
+        delete function_body_pack_;
+    }
 
+  private:
+    void serialize() {
         for (const auto &key_value : functions_) {
-            function_writer_ << key_value.first << " , " << key_value.second
-                             << std::endl;
+            const function_key_t &key = key_value.first;
+            functions_data_table_->write_row(
+                function_ids_[key.function_handle],
+                sexptype_to_string(key.type), key.formal_parameter_count,
+                names_[key.name_handle],
+                sexptype_to_string(key.return_value_type),
+                static_cast<double>(key_value.second));
         }
-        function_writer_.close();
     }
 
-    void write_function_body_(const fn_id_t &fn_id,
-                              const std::string &definition) {
-        auto result = handled_functions_.insert(fn_id);
-        if (!result.second)
-            return;
-        std::ofstream fout(output_dir_ + "/functions/" + fn_id,
-                           std::ios::trunc);
-        fout << definition;
-        fout.close();
+    /* returns the handle of the string and whether it was seen for the
+       first time. */
+    std::pair<int, bool>
+    intern_(std::unordered_map<std::string, int> &handles,
+            std::vector<std::string> &strings, const std::string &value) {
+        /* find before insert so that the common case of an already seen
+           string does not copy it into a temporary key */
+        auto iter = handles.find(value);
+        if (iter != handles.end())
+            return {iter->second, false};
+        int handle = strings.size();
+        handles.insert({value, handle});
+        strings.push_back(value);
+        return {handle, true};
     }
 
-    void pop_function_(const std::string &return_value_type) {
-        std::string key{function_stack_.back()};
+    void pop_function_(sexptype_t return_value_type) {
+        function_key_t key{function_stack_.back()};
         function_stack_.pop_back();
-        key.append(" , ").append(return_value_type);
+        key.return_value_type = return_value_type;
         auto result = functions_.insert({key, 1});
         if (!result.second) {
             ++result.first->second;
         }
     }
 
-    void push_function_(fn_id_t fn_id, const std::string &type,
-                        int formal_parameter_count, const std::string &name) {
-        std::string key(fn_id + " , " + type + " , " +
-                        std::to_string(formal_parameter_count) + " , " + name);
-        function_stack_.push_back(key);
+    void push_function_(const fn_id_t &fn_id, sexptype_t type,
+                        int formal_parameter_count, const std::string &name,
+                        const std::string &definition) {
+        auto function = intern_(function_handles_, function_ids_, fn_id);
+        /* the function body is written only the first time the function
+           is seen */
+        if (function.second)
+            function_body_pack_->add(fn_id, definition);
+        auto name_handle = intern_(name_handles_, names_, name).first;
+        function_stack_.push_back({function.first, name_handle,
+                                   formal_parameter_count, type, NILSXP});
     }
 
     const tracer_state_t &tracer_state_;
     std::string output_dir_;
-    const std::string closure_type_;
-    const std::string special_type_;
-    const std::string builtin_type_;
-    std::unordered_map<std::string, int> functions_;
-    std::unordered_set<fn_id_t> handled_functions_;
-    std::vector<std::string> function_stack_;
+    std::unordered_map<std::string, int> function_handles_;
+    std::vector<fn_id_t> function_ids_;
+    std::unordered_map<std::string, int> name_handles_;
+    std::vector<std::string> names_;
+    std::unordered_map<function_key_t, unsigned long long int,
+                       function_key_hash_t>
+        functions_;
+    std::vector<function_key_t> function_stack_;
+    DataTableStream *functions_data_table_;
+    FunctionBodyPack *function_body_pack_;
 };
 
 #endif /* PROMISE_DYNTRACER_FUNCTION_ANALYSIS_H */
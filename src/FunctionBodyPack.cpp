@@ -0,0 +1,323 @@
+#include "FunctionBodyPack.h"
+#include "utilities.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+
+const std::size_t FUNCTION_BODY_PACK_BUFFER_SIZE = 1024 * 1024;
+
+FunctionBodyPack::FunctionBodyPack(const std::string &pack_filepath,
+                                   const std::string &index_filepath,
+                                   bool truncate, int compression_level)
+    : pack_filepath_{pack_filepath}, index_filepath_{index_filepath},
+      compression_level_{compression_level}, offset_{0}, index_stale_{true},
+      compression_context_{nullptr},
+      file_stream_{pack_filepath,
+                   O_WRONLY | O_CREAT | (truncate ? O_TRUNC : O_APPEND)},
+      buffer_stream_{&file_stream_, FUNCTION_BODY_PACK_BUFFER_SIZE} {
+
+    /* when appending to an existing pack, new bodies start at its end and
+       the existing index entries are carried over to the new index. */
+    if (!truncate) {
+        struct stat file_info = {0};
+        if (stat(pack_filepath.c_str(), &file_info) == 0) {
+            offset_ = file_info.st_size;
+        }
+        read_index_();
+    }
+
+    compression_context_ = ZSTD_createCCtx();
+    if (compression_context_ == NULL) {
+        fprintf(stderr, "ZSTD_createCCtx() error \n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void FunctionBodyPack::add(const std::string &id, const std::string &body) {
+    if (!ids_.insert(id).second) {
+        return;
+    }
+
+    std::size_t bound = ZSTD_compressBound(body.size());
+    if (compression_buffer_.size() < bound) {
+        compression_buffer_.resize(bound);
+    }
+
+    std::size_t compressed_size = ZSTD_compressCCtx(
+        compression_context_, compression_buffer_.data(), bound, body.c_str(),
+        body.size(), compression_level_);
+
+    if (ZSTD_isError(compressed_size)) {
+        fprintf(stderr, "ZSTD_compressCCtx() error : %s \n",
+                ZSTD_getErrorName(compressed_size));
+        exit(EXIT_FAILURE);
+    }
+
+    buffer_stream_.write(compression_buffer_.data(), compressed_size);
+    entries_.push_back({id, offset_, compressed_size, body.size()});
+    offset_ += compressed_size;
+    index_stale_ = true;
+}
+
+void FunctionBodyPack::flush() {
+    /* the bodies go first so that the index never points past the end of
+       the pack */
+    buffer_stream_.flush();
+    if (index_stale_) {
+        write_index_();
+    }
+}
+
+FunctionBodyPack::~FunctionBodyPack() {
+    buffer_stream_.flush();
+    ZSTD_freeCCtx(compression_context_);
+    if (index_stale_) {
+        write_index_();
+    }
+}
+
+void FunctionBodyPack::read_index_() {
+    if (!file_exists(index_filepath_)) {
+        return;
+    }
+
+    auto const[data, size] = map_to_memory(index_filepath_);
+    if (data == NULL) {
+        return;
+    }
+
+    const char *buffer = static_cast<const char *>(data);
+    const std::size_t header_size = 2 * sizeof(std::uint32_t);
+    std::uint32_t entry_count = 0;
+    std::uint32_t id_width = 0;
+    if (size >= header_size) {
+        std::memcpy(&entry_count, buffer, sizeof(entry_count));
+        buffer += sizeof(entry_count);
+        std::memcpy(&id_width, buffer, sizeof(id_width));
+        buffer += sizeof(id_width);
+    }
+
+    const std::size_t entry_size =
+        std::size_t{id_width} + 3 * sizeof(std::uint64_t);
+    if (size < header_size ||
+        (size - header_size) / entry_size < entry_count) {
+        fprintf(stderr, "ignoring truncated function body index %s\n",
+                index_filepath_.c_str());
+        unmap_memory(data, size);
+        return;
+    }
+
+    entries_.reserve(entry_count);
+    for (std::uint32_t index = 0; index < entry_count; ++index) {
+        entry_t entry;
+        entry.id = std::string(buffer, strnlen(buffer, id_width));
+        buffer += id_width;
+        std::memcpy(&entry.offset, buffer, sizeof(entry.offset));
+        buffer += sizeof(entry.offset);
+        std::memcpy(&entry.compressed_size, buffer,
+                    sizeof(entry.compressed_size));
+        buffer += sizeof(entry.compressed_size);
+        std::memcpy(&entry.size, buffer, sizeof(entry.size));
+        buffer += sizeof(entry.size);
+        if (ids_.insert(entry.id).second) {
+            entries_.push_back(entry);
+        }
+    }
+
+    unmap_memory(data, size);
+}
+
+void FunctionBodyPack::write_index_() {
+    /* ids are unique, add and read_index_ skip the ones already seen */
+    std::sort(entries_.begin(), entries_.end(),
+              [](const entry_t &a, const entry_t &b) { return a.id < b.id; });
+
+    std::uint32_t entry_count = entries_.size();
+    std::uint32_t id_width = 0;
+    for (const auto &entry : entries_) {
+        id_width =
+            std::max(id_width, static_cast<std::uint32_t>(entry.id.size()));
+    }
+
+    FileStream index_stream(index_filepath_, O_WRONLY | O_CREAT | O_TRUNC);
+    BufferStream buffer_stream(&index_stream, FUNCTION_BODY_PACK_BUFFER_SIZE);
+
+    buffer_stream.write(&entry_count, sizeof(entry_count));
+    buffer_stream.write(&id_width, sizeof(id_width));
+
+    for (const auto &entry : entries_) {
+        buffer_stream.write(entry.id.c_str(), entry.id.size());
+        if (entry.id.size() < id_width) {
+            buffer_stream.fill(0, id_width - entry.id.size());
+        }
+        buffer_stream.write(&entry.offset, sizeof(entry.offset));
+        buffer_stream.write(&entry.compressed_size,
+                            sizeof(entry.compressed_size));
+        buffer_stream.write(&entry.size, sizeof(entry.size));
+    }
+
+    index_stale_ = false;
+}
+
+SEXP read_function_body(SEXP pack_filepath, SEXP index_filepath,
+                        SEXP function_ids) {
+
+    /* the arguments are checked before any C++ object is alive, R raises
+       an error with a long jump on elements of the wrong type */
+    if (TYPEOF(pack_filepath) != STRSXP || LENGTH(pack_filepath) != 1 ||
+        TYPEOF(index_filepath) != STRSXP || LENGTH(index_filepath) != 1) {
+        Rf_error("pack and index filepaths must be strings");
+    }
+    if (TYPEOF(function_ids) != STRSXP) {
+        Rf_error("function ids must be a character vector");
+    }
+
+    int id_count = LENGTH(function_ids);
+    SEXP bodies = PROTECT(allocVector(STRSXP, id_count));
+
+    /* Rf_error long jumps over destructors, so errors are formatted here
+       and raised once the strings and buffers below are gone */
+    char error[1024] = "";
+
+    {
+        const std::string pack_filepath_unwrapped =
+            sexp_to_string(pack_filepath);
+        const std::string index_filepath_unwrapped =
+            sexp_to_string(index_filepath);
+
+        auto const[index_data, index_size] =
+            map_to_memory(index_filepath_unwrapped);
+        auto const[pack_data, pack_size] =
+            map_to_memory(pack_filepath_unwrapped);
+
+        const char *index = static_cast<const char *>(index_data);
+        const char *pack = static_cast<const char *>(pack_data);
+        const std::size_t header_size = 2 * sizeof(std::uint32_t);
+
+        std::uint32_t entry_count = 0;
+        std::uint32_t id_width = 0;
+        const char *entries = nullptr;
+
+        /* an empty or missing index has no entries */
+        if (index != NULL) {
+            if (index_size < header_size) {
+                std::snprintf(error, sizeof(error), "index %s is truncated",
+                              index_filepath_unwrapped.c_str());
+            } else {
+                std::memcpy(&entry_count, index, sizeof(entry_count));
+                std::memcpy(&id_width, index + sizeof(entry_count),
+                            sizeof(id_width));
+                entries = index + header_size;
+            }
+        }
+
+        const std::size_t entry_size =
+            std::size_t{id_width} + 3 * sizeof(std::uint64_t);
+
+        if (entries != nullptr &&
+            (index_size - header_size) / entry_size < entry_count) {
+            std::snprintf(error, sizeof(error),
+                          "index %s is truncated, it does not hold %u entries",
+                          index_filepath_unwrapped.c_str(), entry_count);
+            entry_count = 0;
+        }
+
+        std::vector<char> body;
+
+        for (int id_index = 0; id_index < id_count && error[0] == '\0';
+             ++id_index) {
+            const char *id = CHAR(STRING_ELT(function_ids, id_index));
+            std::size_t id_size = strlen(id);
+
+            SET_STRING_ELT(bodies, id_index, NA_STRING);
+
+            if (id_size > id_width) {
+                continue;
+            }
+
+            /* binary search over the fixed width records of the index */
+            std::size_t low = 0;
+            std::size_t high = entry_count;
+            const char *entry = nullptr;
+
+            while (low < high) {
+                std::size_t middle = low + (high - low) / 2;
+                const char *candidate = entries + middle * entry_size;
+                int comparison = strncmp(candidate, id, id_width);
+                if (comparison < 0) {
+                    low = middle + 1;
+                } else if (comparison > 0) {
+                    high = middle;
+                } else {
+                    entry = candidate;
+                    break;
+                }
+            }
+
+            if (entry == nullptr) {
+                continue;
+            }
+
+            std::uint64_t offset = 0;
+            std::uint64_t compressed_size = 0;
+            std::uint64_t size = 0;
+            entry += id_width;
+            std::memcpy(&offset, entry, sizeof(offset));
+            std::memcpy(&compressed_size, entry + sizeof(offset),
+                        sizeof(compressed_size));
+            std::memcpy(&size,
+                        entry + sizeof(offset) + sizeof(compressed_size),
+                        sizeof(size));
+
+            if (compressed_size > pack_size ||
+                offset > pack_size - compressed_size) {
+                std::snprintf(error, sizeof(error),
+                              "entry for function %s lies outside of %s", id,
+                              pack_filepath_unwrapped.c_str());
+                break;
+            }
+
+            /* the size recorded in the index is only trusted if the frame
+               agrees with it, and it has to fit in an R string */
+            if (ZSTD_getFrameContentSize(pack + offset, compressed_size) !=
+                    size ||
+                size > static_cast<std::uint64_t>(INT_MAX)) {
+                std::snprintf(error, sizeof(error),
+                              "entry for function %s in %s has an invalid "
+                              "size",
+                              id, index_filepath_unwrapped.c_str());
+                break;
+            }
+
+            body.resize(size + 1);
+            std::size_t decompressed_size = ZSTD_decompress(
+                body.data(), size, pack + offset, compressed_size);
+
+            if (ZSTD_isError(decompressed_size)) {
+                std::snprintf(error, sizeof(error),
+                              "unable to decompress body of function %s : %s",
+                              id, ZSTD_getErrorName(decompressed_size));
+                break;
+            }
+
+            body[decompressed_size] = '\0';
+            SET_STRING_ELT(bodies, id_index,
+                           mkCharLen(body.data(), decompressed_size));
+        }
+
+        if (index_data != NULL) {
+            unmap_memory(index_data, index_size);
+        }
+        if (pack_data != NULL) {
+            unmap_memory(pack_data, pack_size);
+        }
+    }
+
+    UNPROTECT(1);
+
+    if (error[0] != '\0') {
+        Rf_error("%s", error);
+    }
+
+    return bodies;
+}
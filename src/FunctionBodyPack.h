@@ -0,0 +1,81 @@
+#ifndef PROMISEDYNTRACER_FUNCTION_BODY_PACK_H
+#define PROMISEDYNTRACER_FUNCTION_BODY_PACK_H
+
+#include "BufferStream.h"
+#include "FileStream.h"
+#include <Rinternals.h>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <zstd.h>
+
+/* Append-only store of function bodies keyed by function id.
+   Each body is compressed independently into a zstd frame and appended to
+   the pack file. The index file is written by flush and when the pack is
+   destroyed and contains one fixed width record per function, sorted by
+   id, so that a reader can binary search it after mapping it to memory.
+
+   index layout:
+       uint32 entry_count
+       uint32 id_width
+       entry_count * { char id[id_width] (zero padded),
+                       uint64 offset,
+                       uint64 compressed_size,
+                       uint64 size }
+*/
+class FunctionBodyPack {
+  public:
+    struct entry_t {
+        std::string id;
+        std::uint64_t offset;
+        std::uint64_t compressed_size;
+        std::uint64_t size;
+    };
+
+    FunctionBodyPack(const std::string &pack_filepath,
+                     const std::string &index_filepath, bool truncate,
+                     int compression_level);
+
+    /* function ids are hashes of the function body. A body which is added
+       again under an existing id, in this run or in the pack appended to,
+       is ignored. */
+    void add(const std::string &id, const std::string &body);
+
+    /* writes the buffered bodies to the pack and the index next to it, so
+       that the pack is readable even if the pack is never destroyed. */
+    void flush();
+
+    ~FunctionBodyPack();
+
+  private:
+    void read_index_();
+    void write_index_();
+
+    std::string pack_filepath_;
+    std::string index_filepath_;
+    int compression_level_;
+    std::uint64_t offset_;
+    std::vector<entry_t> entries_;
+    std::unordered_set<std::string> ids_;
+    bool index_stale_;
+    std::vector<char> compression_buffer_;
+    ZSTD_CCtx *compression_context_;
+    /* the buffer is declared after the file so that it is flushed before
+       the file is closed */
+    FileStream file_stream_;
+    BufferStream buffer_stream_;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+SEXP read_function_body(SEXP pack_filepath, SEXP index_filepath,
+                        SEXP function_ids);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROMISEDYNTRACER_FUNCTION_BODY_PACK_H */
@@ -1,6 +1,7 @@
 #ifndef __FUNCTION_STATE_H__
 #define __FUNCTION_STATE_H__
 
+#include "ForceOrder.h"
 #include "ParameterUse.h"
 #include "State.h"
 #include "utilities.h"
@@ -10,7 +11,8 @@ class FunctionState {
     FunctionState(std::size_t formal_parameter_count)
         : formal_parameter_count_{formal_parameter_count},
           default_parameter_uses_{formal_parameter_count},
-          custom_parameter_uses_{formal_parameter_count}, call_count_{0} {}
+          custom_parameter_uses_{formal_parameter_count}, call_count_{0},
+          parameter_use_counts_{formal_parameter_count} {}
 
     const std::size_t get_formal_parameter_count() const {
         return formal_parameter_count_;
@@ -26,30 +28,51 @@ class FunctionState {
 
     void increment_call() { ++call_count_; }
 
-    void add_order(const std::string &order) {
-        for (size_t i = 0; i < orders_.size(); ++i) {
-            if (orders_[i] == order) {
-                ++order_counts_[i];
-                return;
-            }
+    void add_order(const ForceOrder &order) {
+        auto iter = order_counts_.find(order);
+        if (iter != order_counts_.end()) {
+            ++iter->second;
+        } else {
+            order_counts_.insert({order, 1});
         }
-        orders_.push_back(order);
-        order_counts_.push_back(1);
     }
 
-    const std::vector<std::string> &get_orders() const { return orders_; }
-
-    const std::vector<std::size_t> &get_order_counts() const {
+    const std::unordered_map<ForceOrder, std::size_t> &
+    get_order_counts() const {
         return order_counts_;
     }
 
+    /* Adds the parameter uses of a finished call to the per position
+       histogram of distinct uses. */
+    void add_parameter_uses(const std::vector<ParameterUse> &parameter_uses) {
+        if (parameter_use_counts_.size() < parameter_uses.size()) {
+            parameter_use_counts_.resize(parameter_uses.size());
+        }
+        for (std::size_t position = 0; position < parameter_uses.size();
+             ++position) {
+            auto &counts = parameter_use_counts_[position];
+            auto iter = counts.find(parameter_uses[position]);
+            if (iter != counts.end()) {
+                ++iter->second;
+            } else {
+                counts.insert({parameter_uses[position], 1});
+            }
+        }
+    }
+
+    const std::vector<std::unordered_map<ParameterUse, std::size_t>> &
+    get_parameter_use_counts() const {
+        return parameter_use_counts_;
+    }
+
   private:
     std::size_t formal_parameter_count_;
     std::size_t call_count_;
     std::vector<ParameterUse> default_parameter_uses_;
     std::vector<ParameterUse> custom_parameter_uses_;
-    std::vector<std::string> orders_;
-    std::vector<std::size_t> order_counts_;
+    std::unordered_map<ForceOrder, std::size_t> order_counts_;
+    std::vector<std::unordered_map<ParameterUse, std::size_t>>
+        parameter_use_counts_;
 };
 
 #endif /* __FUNCTION_STATE_H__ */
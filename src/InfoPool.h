@@ -0,0 +1,51 @@
+#ifndef PROMISEDYNTRACER_INFO_POOL_H
+#define PROMISEDYNTRACER_INFO_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/* Recycles the info structs which the recorder fills for every probe. The
+   structs are only used for the duration of a probe, so a probe takes a
+   slot on entry and gives it back on exit. Probes can nest, a deparse can
+   run a gc for instance, hence one slot per nesting depth. A recycled
+   struct keeps the capacity of its strings and vectors, so once the slots
+   have grown to the sizes of the traced program, filling them does not
+   allocate. Giving a slot back frees all the slots above it, which also
+   reclaims the slots of a probe that was left by a long jump. */
+template <typename T> class InfoPool {
+  public:
+    class Slot {
+      public:
+        Slot(InfoPool &pool, std::size_t index)
+            : pool_(pool), index_(index), info_(*pool.slots_[index]) {}
+
+        Slot(const Slot &) = delete;
+        Slot &operator=(const Slot &) = delete;
+
+        ~Slot() { pool_.used_ = index_; }
+
+        T &get() const { return info_; }
+
+      private:
+        InfoPool &pool_;
+        std::size_t index_;
+        T &info_;
+    };
+
+    InfoPool() : used_{0} {}
+
+    Slot acquire() {
+        if (used_ == slots_.size())
+            slots_.push_back(std::make_unique<T>());
+        return Slot(*this, used_++);
+    }
+
+    std::size_t size() const { return slots_.size(); }
+
+  private:
+    std::vector<std::unique_ptr<T>> slots_;
+    std::size_t used_;
+};
+
+#endif /* PROMISEDYNTRACER_INFO_POOL_H */
@@ -0,0 +1,16 @@
+#include "LocationCache.h"
+#include "utilities.h"
+
+LocationCache::LocationCache() : enabled_{true} {
+    locations_.push_back("");
+    ids_.insert({"", UNKNOWN_LOCATION});
+}
+
+location_id_t LocationCache::intern_(const SEXP srcref) {
+    std::string location = extract_location_information(srcref);
+    auto result = ids_.insert({location, (location_id_t)locations_.size()});
+    if (result.second)
+        locations_.push_back(location);
+    srcrefs_.insert({srcref, result.first->second});
+    return result.first->second;
+}
@@ -0,0 +1,55 @@
+#ifndef PROMISEDYNTRACER_LOCATION_CACHE_H
+#define PROMISEDYNTRACER_LOCATION_CACHE_H
+
+#include "stdlibs.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef int location_id_t;
+
+/* Interns the source locations of call sites and function definitions.
+   The srcref objects are stable, so a location is formatted the first
+   time its srcref is seen and looked up by the srcref afterwards. The
+   entry of a srcref is removed when it is collected, as its address can
+   be reused, but its location keeps its id. Id 0 is the unknown
+   location. Without a consumer of the locations, the cache is disabled:
+   every location is unknown and no srcref is tracked. */
+class LocationCache {
+  public:
+    static constexpr location_id_t UNKNOWN_LOCATION = 0;
+
+    LocationCache();
+
+    void enable(bool enabled) { enabled_ = enabled; }
+
+    bool is_enabled() const { return enabled_; }
+
+    location_id_t intern(const SEXP srcref) {
+        if (!enabled_ || srcref == nullptr || srcref == R_NilValue)
+            return UNKNOWN_LOCATION;
+        auto iter = srcrefs_.find(srcref);
+        if (iter != srcrefs_.end())
+            return iter->second;
+        return intern_(srcref);
+    }
+
+    void remove(const SEXP srcref) {
+        if (!srcrefs_.empty())
+            srcrefs_.erase(srcref);
+    }
+
+    const std::string &get(location_id_t id) const { return locations_[id]; }
+
+    std::size_t size() const { return locations_.size(); }
+
+  private:
+    location_id_t intern_(const SEXP srcref);
+
+    bool enabled_;
+    std::unordered_map<SEXP, location_id_t> srcrefs_;
+    std::unordered_map<std::string, location_id_t> ids_;
+    std::vector<std::string> locations_;
+};
+
+#endif /* PROMISEDYNTRACER_LOCATION_CACHE_H */
@@ -0,0 +1,80 @@
+#ifndef PROMISEDYNTRACER_MEMORY_ACCOUNT_H
+#define PROMISEDYNTRACER_MEMORY_ACCOUNT_H
+
+#include "DataTableStream.h"
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/* Entry counts and approximate sizes in bytes of the containers of the
+   tracer state and the analyses. The sizes are estimated from the element
+   sizes and the usual node layout of the standard containers; allocator
+   overhead and the heap memory owned by the elements are ignored unless
+   the owner adds it explicitly. */
+class MemoryAccount {
+  public:
+    struct usage_t {
+        std::string component;
+        std::size_t entries;
+        std::size_t bytes;
+    };
+
+    void add(const std::string &component, std::size_t entries,
+             std::size_t bytes) {
+        usages_.push_back({component, entries, bytes});
+    }
+
+    void add_table(const std::string &component,
+                   const DataTableStream *table) {
+        if (table != nullptr) {
+            add(component, table->get_current_row_index(),
+                table->get_buffer_capacity());
+        }
+    }
+
+    const std::vector<usage_t> &get_usages() const { return usages_; }
+
+  private:
+    std::vector<usage_t> usages_;
+};
+
+/* heap memory owned by the string, short strings are stored inline */
+inline std::size_t approximate_memory_size(const std::string &value) {
+    return value.capacity() > 15 ? value.capacity() + 1 : 0;
+}
+
+template <typename T>
+std::size_t approximate_memory_size(const std::vector<T> &vector) {
+    return vector.capacity() * sizeof(T);
+}
+
+/* each node holds the value, the next pointer and the cached hash */
+template <typename K, typename V, typename H, typename E, typename A>
+std::size_t
+approximate_memory_size(const std::unordered_map<K, V, H, E, A> &map) {
+    return map.bucket_count() * sizeof(void *) +
+           map.size() * (sizeof(std::pair<const K, V>) + 2 * sizeof(void *));
+}
+
+template <typename K, typename H, typename E, typename A>
+std::size_t approximate_memory_size(const std::unordered_set<K, H, E, A> &set) {
+    return set.bucket_count() * sizeof(void *) +
+           set.size() * (sizeof(K) + 2 * sizeof(void *));
+}
+
+/* each red black tree node holds the value, three pointers and the color */
+template <typename K, typename V, typename C, typename A>
+std::size_t approximate_memory_size(const std::map<K, V, C, A> &map) {
+    return map.size() * (sizeof(std::pair<const K, V>) + 4 * sizeof(void *));
+}
+
+template <typename K, typename C, typename A>
+std::size_t approximate_memory_size(const std::set<K, C, A> &set) {
+    return set.size() * (sizeof(K) + 4 * sizeof(void *));
+}
+
+#endif /* PROMISEDYNTRACER_MEMORY_ACCOUNT_H */
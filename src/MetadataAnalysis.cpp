@@ -1,8 +1,12 @@
 #include "MetadataAnalysis.h"
 
 MetadataAnalysis::MetadataAnalysis(const tracer_state_t &tracer_state,
-                                   const std::string &output_dir)
-    : tracer_state_(tracer_state), output_dir_(output_dir) {}
+                                   const std::string &output_dir,
+                                   bool truncate, bool binary,
+                                   int compression_level)
+    : tracer_state_(tracer_state), output_dir_(output_dir),
+      truncate_(truncate), binary_(binary),
+      compression_level_(compression_level) {}
 
 void MetadataAnalysis::end(dyntracer_t *dyntracer) {
     std::ofstream fout(output_dir_ + "/metadata.csv", std::ios::trunc);
@@ -21,6 +25,24 @@ void MetadataAnalysis::end(dyntracer_t *dyntracer) {
     serialize_row(fout, "RDT_COMPILE_VIGNETTE",
                   to_string(getenv("RDT_COMPILE_VIGNETTE")));
 
+    /* aggregates of a sampled run are reweighted by the rate */
+    const CallSampler &sampler = tracer_state_.call_sampler;
+    serialize_row(fout, "SAMPLING_MODE",
+                  sampling_mode_to_string(sampler.get_mode()));
+    serialize_row(fout, "SAMPLING_RATE", std::to_string(sampler.get_rate()));
+    serialize_row(fout, "SAMPLED_CALLS",
+                  std::to_string(sampler.get_sampled_calls()));
+    serialize_row(fout, "SKIPPED_CALLS",
+                  std::to_string(sampler.get_skipped_calls()));
+
+    const CallFilter &filter = tracer_state_.call_filter;
+    serialize_row(fout, "FILTERED_CALLS",
+                  std::to_string(filter.get_filtered_calls()));
+
+    for (const auto &entry : entries_) {
+        serialize_row(fout, entry.first, entry.second);
+    }
+
     // serialize_row(fout, "DYNTRACE_END_DATETIME",
     //               context->dyntracing_context->end_datetime);
     // serialize_row(fout, "PROBE_FUNCTION_ENTRY",
@@ -92,9 +114,47 @@ void MetadataAnalysis::end(dyntracer_t *dyntracer) {
     timer_serializer(Timer::recorder_timer());
     timer_serializer(Timer::analysis_timer());
 
+    serialize_timing();
+
 #endif
 }
 
+void MetadataAnalysis::serialize_timing() {
+#ifdef DYNTRACE_ENABLE_TIMING
+
+    DataTableStream *timing_data_table = create_data_table(
+        output_dir_ + "/" + "timing",
+        {"timer", "segment", "count", "total_ns", "p50_ns", "p90_ns", "p99_ns",
+         "max_ns"},
+        truncate_, binary_, compression_level_);
+
+    for (Timer *timer : {&Timer::main_timer(), &Timer::recorder_timer(),
+                         &Timer::analysis_timer()}) {
+        for (int i = 0; i < TimerSegment::TIMER_SEGMENT_COUNT; ++i) {
+            TimerSegment segment = static_cast<TimerSegment>(i);
+            if (timer->get_occurrences(segment) == 0)
+                continue;
+            timing_data_table->write_row(
+                timer->get_name(), timer_segment_name(segment),
+                static_cast<double>(timer->get_occurrences(segment)),
+                timer->get_total_nanoseconds(segment),
+                timer->get_quantile_nanoseconds(segment, 0.50),
+                timer->get_quantile_nanoseconds(segment, 0.90),
+                timer->get_quantile_nanoseconds(segment, 0.99),
+                timer->get_max_nanoseconds(segment));
+        }
+    }
+
+    delete timing_data_table;
+
+#endif
+}
+
+void MetadataAnalysis::add_entry(const std::string &key,
+                                 const std::string &value) {
+    entries_.push_back({key, value});
+}
+
 void MetadataAnalysis::serialize_row(std::ofstream &fout, std::string key,
                                      std::string value) {
     fout << key << " , "
@@ -3,19 +3,27 @@
 
 #include "State.h"
 #include "Timer.h"
+#include "table.h"
 #include "utilities.h"
 
 class MetadataAnalysis {
   public:
     MetadataAnalysis(const tracer_state_t &tracer_state,
-                     const std::string &output_dir);
+                     const std::string &output_dir, bool truncate, bool binary,
+                     int compression_level);
     void end(dyntracer_t *dyntracer);
+    void add_entry(const std::string &key, const std::string &value);
 
   private:
     void serialize_row(std::ofstream &fout,
                        std::string key,
                        std::string value);
+    void serialize_timing();
     std::string output_dir_;
+    bool truncate_;
+    bool binary_;
+    int compression_level_;
+    std::vector<std::pair<std::string, std::string>> entries_;
     const tracer_state_t &tracer_state_;
 };
 
@@ -32,6 +32,20 @@ class ParameterUse {
 
     void set_parameter_mode(parameter_mode_t mode) { mode_ = mode; }
 
+    bool operator==(const ParameterUse &other) const {
+        return type_ == other.type_ && force_ == other.force_ &&
+               lookup_ == other.lookup_ &&
+               metaprogram_ == other.metaprogram_ && mode_ == other.mode_;
+    }
+
+    std::size_t hash() const {
+        return (static_cast<std::size_t>(type_) << 32) |
+               (static_cast<std::size_t>(mode_) << 24) |
+               (static_cast<std::size_t>(force_) << 16) |
+               (static_cast<std::size_t>(lookup_) << 8) |
+               static_cast<std::size_t>(metaprogram_);
+    }
+
   private:
     sexptype_t type_;
     std::uint8_t force_;
@@ -40,4 +54,12 @@ class ParameterUse {
     parameter_mode_t mode_;
 };
 
+namespace std {
+template <> struct hash<ParameterUse> {
+    std::size_t operator()(const ParameterUse &parameter_use) const {
+        return parameter_use.hash();
+    }
+};
+} // namespace std
+
 #endif /* PROMISE_DYNTRACER_PARAMETER_USE_H */
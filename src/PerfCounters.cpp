@@ -0,0 +1,98 @@
+#ifdef DYNTRACE_ENABLE_PERF_COUNTERS
+
+#include "PerfCounters.h"
+#include <asm/unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <utility>
+
+PerfCounters::PerfCounters() : group_fd_{-1}, open_count_{0} {
+    const std::pair<std::uint32_t, std::uint64_t> events[COUNTER_COUNT] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}};
+
+    for (int counter = 0; counter < COUNTER_COUNT; ++counter) {
+        fds_[counter] = -1;
+        positions_[counter] = -1;
+    }
+
+    group_fd_ = open_counter_(events[CYCLES].first, events[CYCLES].second, -1);
+    if (group_fd_ == -1) {
+        error_ = std::strerror(errno);
+        return;
+    }
+    fds_[CYCLES] = group_fd_;
+    positions_[CYCLES] = open_count_++;
+
+    for (int counter = CYCLES + 1; counter < COUNTER_COUNT; ++counter) {
+        int fd = open_counter_(events[counter].first, events[counter].second,
+                               group_fd_);
+        if (fd != -1) {
+            fds_[counter] = fd;
+            positions_[counter] = open_count_++;
+        }
+    }
+
+    ioctl(group_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+PerfCounters::~PerfCounters() {
+    for (int counter = COUNTER_COUNT - 1; counter >= 0; --counter) {
+        if (fds_[counter] != -1) {
+            close(fds_[counter]);
+        }
+    }
+}
+
+int PerfCounters::open_counter_(std::uint32_t type, std::uint64_t config,
+                                int group_fd) {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group_fd == -1;
+    /* user space counts only, these are permitted at the default
+       perf_event_paranoid level */
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+void PerfCounters::read(counts_t counts) const {
+    std::uint64_t values[COUNTER_COUNT + 1] = {0};
+    if (group_fd_ == -1 || ::read(group_fd_, values, sizeof(values)) <
+                               (ssize_t)sizeof(values[0])) {
+        std::memset(counts, 0, sizeof(counts_t));
+        return;
+    }
+    /* the group read starts with the number of counters */
+    for (int counter = 0; counter < COUNTER_COUNT; ++counter) {
+        counts[counter] =
+            positions_[counter] == -1 ? 0 : values[1 + positions_[counter]];
+    }
+}
+
+const char *PerfCounters::get_counter_name(Counter counter) {
+    switch (counter) {
+        case CYCLES:
+            return "cycles";
+        case INSTRUCTIONS:
+            return "instructions";
+        case LLC_MISSES:
+            return "llc_misses";
+        case BRANCH_MISSES:
+            return "branch_misses";
+        default:
+            return "";
+    }
+}
+
+#endif /* DYNTRACE_ENABLE_PERF_COUNTERS */
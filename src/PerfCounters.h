@@ -0,0 +1,51 @@
+#ifndef PROMISEDYNTRACER_PERF_COUNTERS_H
+#define PROMISEDYNTRACER_PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+/* Group of hardware performance counters of the tracing thread, opened with
+   perf_event_open. The whole group is read with a single system call. If
+   the counters are not permitted, for instance because of
+   perf_event_paranoid, or not supported by the processor, the group is
+   unavailable and reads return zeros, so that the timer only reports wall
+   time. A counter which alone fails to open reads as zero. */
+class PerfCounters {
+  public:
+    enum Counter {
+        CYCLES = 0,
+        INSTRUCTIONS,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        COUNTER_COUNT
+    };
+
+    using counts_t = std::uint64_t[COUNTER_COUNT];
+
+    PerfCounters();
+
+    ~PerfCounters();
+
+    PerfCounters(PerfCounters const &) = delete;
+    PerfCounters &operator=(PerfCounters const &) = delete;
+
+    bool is_available() const { return group_fd_ != -1; }
+
+    const std::string &get_error() const { return error_; }
+
+    void read(counts_t counts) const;
+
+    static const char *get_counter_name(Counter counter);
+
+  private:
+    int open_counter_(std::uint32_t type, std::uint64_t config, int group_fd);
+
+    int group_fd_;
+    int fds_[COUNTER_COUNT];
+    /* position of each counter in the group read, -1 if it is not open */
+    int positions_[COUNTER_COUNT];
+    int open_count_;
+    std::string error_;
+};
+
+#endif /* PROMISEDYNTRACER_PERF_COUNTERS_H */
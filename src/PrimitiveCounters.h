@@ -0,0 +1,44 @@
+#ifndef PROMISEDYNTRACER_PRIMITIVE_COUNTERS_H
+#define PROMISEDYNTRACER_PRIMITIVE_COUNTERS_H
+
+#include "stdlibs.h"
+#include <cstdint>
+#include <vector>
+
+/* Calls of each builtin and special, indexed by the offset of the primitive
+   in the table of R functions, so that counting a call is an array
+   increment. The counters grow to the largest offset seen. */
+class PrimitiveCounters {
+  public:
+    static bool is_primitive(const SEXP op) {
+        return TYPEOF(op) == BUILTINSXP || TYPEOF(op) == SPECIALSXP;
+    }
+
+    void count(const SEXP op) {
+        std::size_t offset = PRIMOFFSET(op);
+        if (offset >= calls_.size()) {
+            calls_.resize(offset + 1, 0);
+            types_.resize(offset + 1, NILSXP);
+        }
+        ++calls_[offset];
+        types_[offset] = TYPEOF(op);
+    }
+
+    std::size_t size() const { return calls_.size(); }
+
+    std::uint64_t get_calls(std::size_t offset) const {
+        return calls_[offset];
+    }
+
+    SEXPTYPE get_type(std::size_t offset) const { return types_[offset]; }
+
+    static const char *get_name(std::size_t offset) {
+        return R_FunTab[offset].name;
+    }
+
+  private:
+    std::vector<std::uint64_t> calls_;
+    std::vector<SEXPTYPE> types_;
+};
+
+#endif /* PROMISEDYNTRACER_PRIMITIVE_COUNTERS_H */
@@ -13,61 +13,61 @@ void PromiseEvaluationAnalysis::promise_force_entry(
 
     PromiseState &promise_state = promise_mapper_->find(prom_info.prom_id);
 
-    promise_state.evaluated = true;
+    promise_state.set_evaluated();
 
     update_evaluation_context_count(get_current_evaluation_context());
 
-    if (promise_state.local && promise_state.argument)
-        compute_evaluation_distance(promise_state);
+    if (promise_state.is_local() && promise_state.is_argument())
+        compute_evaluation_distance(promise_state,
+                                    prom_info.promise_environment);
+}
+
+/* Counts are stored in 15 bits so that the parameter mode fits in the
+   remaining 4 bits of the key. Deeper stacks saturate. */
+static const std::uint64_t EVALUATION_DISTANCE_COUNT_MASK = 0x7FFF;
+
+static inline std::uint64_t pack_count(std::uint32_t count) {
+    return std::min<std::uint64_t>(count, EVALUATION_DISTANCE_COUNT_MASK);
 }
 
 void PromiseEvaluationAnalysis::compute_evaluation_distance(
-    const PromiseState &promise_state) {
+    const PromiseState &promise_state, const SEXP environment) {
 
-    std::string key;
-    std::string argument_type = parameter_mode_to_string(promise_state.parameter_mode);
+    /* depth of the topmost call frame whose enclosing environment is the
+       environment of the promise. */
+    int depth = tracer_state_.get_environment_stack_depth(
+        get_sexp_address(environment));
 
-    int closure_count = 0;
-    int builtin_count = 0;
-    int special_count = 0;
-    int promise_count = 0;
+    if (depth == -1)
+        return;
 
-    size_t stack_size = tracer_state_.full_stack.size();
-    for (int i = stack_size - 1; i >= 0; --i) {
-        stack_event_t exec_context = tracer_state_.full_stack[i];
-        if (exec_context.type == stack_type::CALL) {
-            SEXP enclosing_address =
-                reinterpret_cast<SEXP>(exec_context.enclosing_environment);
-            if (promise_state.env_id ==
-                tracer_state_.to_environment_id(enclosing_address)) {
-                std::string key = argument_type + " , " +
-                                  std::to_string(closure_count) + " , " +
-                                  std::to_string(special_count) + " , " +
-                                  std::to_string(builtin_count) + " , " +
-                                  std::to_string(promise_count);
-                update_evaluation_distance(key);
-                return;
-            } else if (exec_context.function_info.type ==
-                       function_type::CLOSURE)
-                closure_count++;
-            else if (exec_context.function_info.type == function_type::SPECIAL)
-                special_count++;
-            else
-                builtin_count++;
-        } else if (exec_context.type == stack_type::PROMISE) {
-            promise_count++;
-        }
-    }
+    const stack_frame_counts_t &top = tracer_state_.full_stack_counts.back();
+    const stack_frame_counts_t &frame = tracer_state_.full_stack_counts[depth];
+
+    std::uint64_t key =
+        (static_cast<std::uint64_t>(promise_state.get_parameter_mode()) << 60) |
+        (pack_count(top.closure - frame.closure) << 45) |
+        (pack_count(top.special - frame.special) << 30) |
+        (pack_count(top.builtin - frame.builtin) << 15) |
+        pack_count(top.promise - frame.promise);
+
+    update_evaluation_distance(key);
 }
 
-void PromiseEvaluationAnalysis::update_evaluation_distance(std::string key) {
-    auto result = evaluation_distances_.emplace(make_pair(key, 1));
+void PromiseEvaluationAnalysis::update_evaluation_distance(std::uint64_t key) {
+    auto result = evaluation_distances_.emplace(key, 1);
     if (!result.second)
         ++result.first->second;
 }
 
 void PromiseEvaluationAnalysis::end(dyntracer_t *dyntracer) { serialize(); }
 
+void PromiseEvaluationAnalysis::account_memory(MemoryAccount &account) const {
+    account.add("promise_evaluation_analysis/evaluation_distances",
+                evaluation_distances_.size(),
+                approximate_memory_size(evaluation_distances_));
+}
+
 PromiseEvaluationAnalysis::EvaluationContext
 PromiseEvaluationAnalysis::get_current_evaluation_context() {
 
@@ -116,7 +116,14 @@ void PromiseEvaluationAnalysis::serialize_promise_evaluation_distance() {
          << "count" << std::endl;
 
     for (const auto &key_value : evaluation_distances_) {
-        fout << key_value.first << " , " << key_value.second << std::endl;
+        std::uint64_t key = key_value.first;
+        fout << parameter_mode_to_string(
+                    static_cast<parameter_mode_t>(key >> 60))
+             << " , " << ((key >> 45) & EVALUATION_DISTANCE_COUNT_MASK)
+             << " , " << ((key >> 30) & EVALUATION_DISTANCE_COUNT_MASK)
+             << " , " << ((key >> 15) & EVALUATION_DISTANCE_COUNT_MASK)
+             << " , " << (key & EVALUATION_DISTANCE_COUNT_MASK) << " , "
+             << key_value.second << std::endl;
     }
 
     fout.close();
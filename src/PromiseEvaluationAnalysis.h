@@ -1,10 +1,12 @@
 #ifndef __PROMISE_EVALUATION_ANALYSIS_H__
 #define __PROMISE_EVALUATION_ANALYSIS_H__
 
+#include "MemoryAccount.h"
 #include "PromiseMapper.h"
 #include "PromiseState.h"
 #include "State.h"
 #include <algorithm>
+#include <cstdint>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -25,16 +27,20 @@ class PromiseEvaluationAnalysis {
                               PromiseMapper *promise_mapper);
     void promise_force_entry(const prom_info_t &prom_info, const SEXP promise);
     void end(dyntracer_t *dyntracer);
+    void account_memory(MemoryAccount &account) const;
 
   private:
     void serialize();
     void serialize_promise_evaluation_distance();
     void serialize_evaluation_context_count();
-    void compute_evaluation_distance(const PromiseState &promise_state);
-    void update_evaluation_distance(std::string key);
+    void compute_evaluation_distance(const PromiseState &promise_state,
+                                     const SEXP environment);
+    void update_evaluation_distance(std::uint64_t key);
     EvaluationContext get_current_evaluation_context();
     void update_evaluation_context_count(EvaluationContext evalution_context);
-    std::unordered_map<std::string, int> evaluation_distances_;
+    /* keyed by the parameter mode and the closure, special, builtin and
+       promise counts packed into a single integer. */
+    std::unordered_map<std::uint64_t, int> evaluation_distances_;
     std::vector<int> evaluation_context_counts_;
     std::string output_dir_;
     tracer_state_t &tracer_state_;
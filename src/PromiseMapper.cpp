@@ -3,17 +3,32 @@
 const size_t PromiseMapper::PROMISE_MAPPING_BUCKET_COUNT = 1000000;
 
 PromiseMapper::PromiseMapper(tracer_state_t &tracer_state,
-                             const std::string &output_dir)
+                             const std::string &output_dir, bool truncate,
+                             bool binary, int compression_level)
     : tracer_state_(tracer_state), output_dir_(output_dir),
       promises_(std::unordered_map<prom_id_t, PromiseState>(
-          PROMISE_MAPPING_BUCKET_COUNT)) {}
+          PROMISE_MAPPING_BUCKET_COUNT)) {
+
+    promise_lifecycle_data_table_ = create_data_table(
+        output_dir + "/" + "promise-lifecycle",
+        {"promise_id", "local", "argument", "environment_id", "function_id",
+         "call_id", "formal_parameter_position", "parameter_mode",
+         "evaluated", "environment_lookups", "environment_assigns",
+         "expression_lookups", "expression_assigns", "value_lookups",
+         "value_assigns", "collected"},
+        truncate, binary, compression_level);
+}
+
+PromiseMapper::~PromiseMapper() { delete promise_lifecycle_data_table_; }
 
 void PromiseMapper::promise_created(const prom_basic_info_t &prom_basic_info,
                                     const SEXP promise) {
     auto result = promises_.insert(
         {prom_basic_info.prom_id,
          PromiseState(prom_basic_info.prom_id,
-                      tracer_state_.to_environment_id(PRENV(promise)), true)});
+                      tracer_state_.to_environment_id(
+                          prom_basic_info.promise_environment),
+                      true)});
     // if result.second is false, this means that a promise with this id
     // already exists in map. This means that the promise with the same id
     // has either not been removed in the gc_promise_unmarked stage or the
@@ -23,6 +38,7 @@ void PromiseMapper::promise_created(const prom_basic_info_t &prom_basic_info,
 
 void PromiseMapper::closure_entry(const closure_info_t &closure_info) {
     int max_position = 0;
+    int function_handle = PromiseState::UNKNOWN_FUNCTION_HANDLE;
     for (const auto &argument : closure_info.arguments) {
         if (argument.value_type != PROMSXP)
             continue;
@@ -41,45 +57,47 @@ void PromiseMapper::closure_entry(const closure_info_t &closure_info) {
         // incorrect insertion to promises_ mapping or missing probes at
         // promise creation point in the interpreter.
         // assert(it != promises_.end());
+        if (function_handle == PromiseState::UNKNOWN_FUNCTION_HANDLE)
+            function_handle = intern_function_id(closure_info.fn_id);
         promise_state.make_function_argument(
-            closure_info.fn_id, closure_info.call_id, formal_parameter_position,
+            function_handle, closure_info.call_id, formal_parameter_position,
             argument.parameter_mode);
     }
 }
 
 void PromiseMapper::promise_force_entry(const prom_info_t &prom_info,
                                         const SEXP promise) {
-    insert_if_non_local(prom_info.prom_id, promise);
+    insert_if_non_local(prom_info);
 }
 
 void PromiseMapper::promise_environment_lookup(const prom_info_t &prom_info,
                                                const SEXP promise) {
-    insert_if_non_local(prom_info.prom_id, promise);
+    insert_if_non_local(prom_info);
 }
 
 void PromiseMapper::promise_expression_lookup(const prom_info_t &prom_info,
                                               const SEXP promise) {
-    insert_if_non_local(prom_info.prom_id, promise);
+    insert_if_non_local(prom_info);
 }
 
 void PromiseMapper::promise_value_lookup(const prom_info_t &prom_info,
                                          const SEXP promise) {
-    insert_if_non_local(prom_info.prom_id, promise);
+    insert_if_non_local(prom_info);
 }
 
 void PromiseMapper::promise_environment_set(const prom_info_t &prom_info,
                                             const SEXP promise) {
-    insert_if_non_local(prom_info.prom_id, promise);
+    insert_if_non_local(prom_info);
 }
 
 void PromiseMapper::promise_expression_set(const prom_info_t &prom_info,
                                            const SEXP promise) {
-    insert_if_non_local(prom_info.prom_id, promise);
+    insert_if_non_local(prom_info);
 }
 
 void PromiseMapper::promise_value_set(const prom_info_t &prom_info,
                                       const SEXP promise) {
-    insert_if_non_local(prom_info.prom_id, promise);
+    insert_if_non_local(prom_info);
 }
 
 void PromiseMapper::gc_promise_unmarked(const prom_id_t prom_id,
@@ -87,10 +105,45 @@ void PromiseMapper::gc_promise_unmarked(const prom_id_t prom_id,
     // it is possible that the promise does not exist in mapping.
     // this happens if the promise was created outside of tracing
     // but is being garbage collected in the middle of tracing
-    promises_.erase(prom_id);
+    auto iter = promises_.find(prom_id);
+    if (iter == promises_.end())
+        return;
+    serialize_promise_state(iter->second, true);
+    promises_.erase(iter);
 }
 
-void PromiseMapper::end(dyntracer_t *dyntracer) { promises_.clear(); }
+void PromiseMapper::end(dyntracer_t *dyntracer) {
+    // promises which are still alive at the end are written as well so that
+    // the table has a row for every promise seen during tracing.
+    for (const auto &key_value : promises_) {
+        serialize_promise_state(key_value.second, false);
+    }
+    promises_.clear();
+}
+
+void PromiseMapper::serialize_promise_state(const PromiseState &promise_state,
+                                            bool collected) {
+    using SlotMutation = PromiseState::SlotMutation;
+    auto mutations = [&](SlotMutation slot_mutation) {
+        return static_cast<int>(
+            promise_state.mutations[to_underlying_type(slot_mutation)]);
+    };
+
+    promise_lifecycle_data_table_->write_row(
+        static_cast<double>(promise_state.id), promise_state.is_local(),
+        promise_state.is_argument(), promise_state.env_id,
+        get_function_id(promise_state.function_handle),
+        static_cast<double>(promise_state.call_id),
+        promise_state.formal_parameter_position,
+        parameter_mode_to_string(promise_state.get_parameter_mode()),
+        promise_state.is_evaluated(),
+        mutations(SlotMutation::ENVIRONMENT_LOOKUP),
+        mutations(SlotMutation::ENVIRONMENT_ASSIGN),
+        mutations(SlotMutation::EXPRESSION_LOOKUP),
+        mutations(SlotMutation::EXPRESSION_ASSIGN),
+        mutations(SlotMutation::VALUE_LOOKUP),
+        mutations(SlotMutation::VALUE_ASSIGN), collected);
+}
 
 PromiseState &PromiseMapper::find(const prom_id_t prom_id) {
     auto iter = promises_.find(prom_id);
@@ -103,15 +156,48 @@ PromiseState &PromiseMapper::find(const prom_id_t prom_id) {
     return iter->second;
 }
 
-void PromiseMapper::insert_if_non_local(const prom_id_t prom_id,
-                                        const SEXP promise) {
+void PromiseMapper::account_memory(MemoryAccount &account) const {
+    account.add("promise_mapper/promises", promises_.size(),
+                approximate_memory_size(promises_));
+    std::size_t function_bytes = approximate_memory_size(function_handles_) +
+                                 approximate_memory_size(function_ids_);
+    for (const auto &function_id : function_ids_) {
+        /* the id is stored both in the vector and as the key of the map */
+        function_bytes += 2 * approximate_memory_size(function_id);
+    }
+    account.add("promise_mapper/function_ids", function_ids_.size(),
+                function_bytes);
+    account.add_table("promise_mapper/promise-lifecycle",
+                      promise_lifecycle_data_table_);
+}
+
+int PromiseMapper::intern_function_id(const fn_id_t &fn_id) {
+    auto iter = function_handles_.find(fn_id);
+    if (iter != function_handles_.end())
+        return iter->second;
+    int function_handle = function_ids_.size();
+    function_handles_.insert({fn_id, function_handle});
+    function_ids_.push_back(fn_id);
+    return function_handle;
+}
+
+const fn_id_t &PromiseMapper::get_function_id(int function_handle) const {
+    static const fn_id_t unknown_function_id{""};
+    if (function_handle == PromiseState::UNKNOWN_FUNCTION_HANDLE)
+        return unknown_function_id;
+    return function_ids_[function_handle];
+}
+
+void PromiseMapper::insert_if_non_local(const prom_info_t &prom_info) {
 
     // the insertion only happens if the promise with this id does not already
     // exist. If the promise does not already exist, it means that we have not
     // seen its creation which means it is non local.
     promises_.insert(
-        {prom_id,
-         PromiseState(prom_id, tracer_state_.to_environment_id(PRENV(promise)),
+        {prom_info.prom_id,
+         PromiseState(prom_info.prom_id,
+                      tracer_state_.to_environment_id(
+                          prom_info.promise_environment),
                       false)});
 }
 
@@ -3,6 +3,8 @@
 
 #include "PromiseState.h"
 #include "State.h"
+#include "MemoryAccount.h"
+#include "table.h"
 #include <algorithm>
 #include <tuple>
 #include <unordered_map>
@@ -15,7 +17,8 @@ class PromiseMapper {
     using iterator = promises_t::iterator;
     using const_iterator = promises_t::const_iterator;
 
-    PromiseMapper(tracer_state_t &tracer_state, const std::string &output_dir);
+    PromiseMapper(tracer_state_t &tracer_state, const std::string &output_dir,
+                  bool truncate, bool binary, int compression_level);
     void promise_created(const prom_basic_info_t &prom_basic_info,
                          const SEXP promise);
     void closure_entry(const closure_info_t &closure_info);
@@ -30,6 +33,9 @@ class PromiseMapper {
     void gc_promise_unmarked(const prom_id_t prom_id, const SEXP promise);
     void end(dyntracer_t *dyntracer);
     PromiseState &find(const prom_id_t prom_id);
+    const fn_id_t &get_function_id(int function_handle) const;
+    void account_memory(MemoryAccount &account) const;
+    ~PromiseMapper();
 
     iterator begin();
     iterator end();
@@ -39,10 +45,17 @@ class PromiseMapper {
     const_iterator cend() const;
 
   private:
-    void insert_if_non_local(const prom_id_t prom_id, const SEXP promise);
+    void insert_if_non_local(const prom_info_t &prom_info);
+    int intern_function_id(const fn_id_t &fn_id);
+    void serialize_promise_state(const PromiseState &promise_state,
+                                 bool collected);
     promises_t promises_;
+    /* function ids of the promise states are interned to handles */
+    std::unordered_map<fn_id_t, int> function_handles_;
+    std::vector<fn_id_t> function_ids_;
     std::string output_dir_;
     tracer_state_t &tracer_state_;
+    DataTableStream *promise_lifecycle_data_table_;
     static const size_t PROMISE_MAPPING_BUCKET_COUNT;
 };
 
@@ -3,7 +3,15 @@
 
 #include "State.h"
 #include "utilities.h"
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 
+/* Per promise state kept by the PromiseMapper for every live promise.
+   The state is a fixed size value without any heap allocated members: the
+   function id is stored as a handle interned by the mapper and the boolean
+   properties and the parameter mode are packed into a single byte. */
 class PromiseState {
   public:
     enum class SlotMutation {
@@ -16,28 +24,62 @@ class PromiseState {
         COUNT
     };
 
-    bool local;
-    bool argument;
+    using mutation_count_t = std::uint16_t;
+
+    static constexpr int UNKNOWN_FUNCTION_HANDLE = -1;
+
     prom_id_t id;
-    env_id_t env_id;
-    fn_id_t fn_id;
     call_id_t call_id;
+    env_id_t env_id;
+    int function_handle;
     int formal_parameter_position;
-    parameter_mode_t parameter_mode;
-    bool evaluated;
-    std::vector<int> mutations;
+    std::array<mutation_count_t, to_underlying_type(SlotMutation::COUNT)>
+        mutations;
 
-    PromiseState(prom_id_t id, env_id_t env_, bool local);
+    PromiseState(prom_id_t id, env_id_t env_id, bool local);
 
-    void make_function_argument(fn_id_t fn_id, call_id_t call_id,
-                                int formal_parameter_position,
-                                parameter_mode_t parameter_mode);
+    inline void make_function_argument(int function_handle, call_id_t call_id,
+                                       int formal_parameter_position,
+                                       parameter_mode_t parameter_mode) {
+        this->function_handle = function_handle;
+        this->call_id = call_id;
+        this->formal_parameter_position = formal_parameter_position;
+        flags_ = (flags_ & EVALUATED_FLAG) | LOCAL_FLAG | ARGUMENT_FLAG |
+                 (to_underlying_type(parameter_mode) << PARAMETER_MODE_SHIFT);
+    }
 
+    /* counters saturate instead of wrapping around */
     inline void increment_mutation_slot(SlotMutation slot_mutation) {
-        ++mutations[to_underlying_type(slot_mutation)];
+        mutation_count_t &count = mutations[to_underlying_type(slot_mutation)];
+        count += (count != std::numeric_limits<mutation_count_t>::max());
+    }
+
+    bool is_local() const { return flags_ & LOCAL_FLAG; }
+
+    bool is_argument() const { return flags_ & ARGUMENT_FLAG; }
+
+    bool is_evaluated() const { return flags_ & EVALUATED_FLAG; }
+
+    void set_evaluated() { flags_ |= EVALUATED_FLAG; }
+
+    parameter_mode_t get_parameter_mode() const {
+        return static_cast<parameter_mode_t>(flags_ >> PARAMETER_MODE_SHIFT);
     }
+
+  private:
+    static constexpr std::uint8_t LOCAL_FLAG = 1 << 0;
+    static constexpr std::uint8_t ARGUMENT_FLAG = 1 << 1;
+    static constexpr std::uint8_t EVALUATED_FLAG = 1 << 2;
+    static constexpr int PARAMETER_MODE_SHIFT = 3;
+
+    std::uint8_t flags_;
 };
 
+static_assert(sizeof(PromiseState) <= 48,
+              "PromiseState should fit in 48 bytes");
+static_assert(std::is_trivially_copyable<PromiseState>::value,
+              "PromiseState should be trivially copyable");
+
 std::string to_string(PromiseState::SlotMutation slot_mutation);
 
 #endif /* __PROMISE_STATE_H__ */
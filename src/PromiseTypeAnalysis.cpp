@@ -13,103 +13,121 @@ PromiseTypeAnalysis::PromiseTypeAnalysis(const tracer_state_t &tracer_state,
     }
 }
 
-inline bool
-PromiseTypeAnalysis::add_default_argument_promise(prom_id_t prom_id) {
-    return default_argument_promises_.insert(prom_id).second;
-}
-
-inline bool
-PromiseTypeAnalysis::add_custom_argument_promise(prom_id_t prom_id) {
-    return custom_argument_promises_.insert(prom_id).second;
-}
-
-inline bool PromiseTypeAnalysis::add_non_argument_promise(prom_id_t prom_id) {
-    return non_argument_promises_.insert(prom_id).second;
-}
-
-inline size_t
-PromiseTypeAnalysis::remove_default_argument_promise(prom_id_t prom_id) {
-    return default_argument_promises_.erase(prom_id);
-}
-
-inline size_t
-PromiseTypeAnalysis::remove_custom_argument_promise(prom_id_t prom_id) {
-    return custom_argument_promises_.erase(prom_id);
-}
-
-inline size_t
-PromiseTypeAnalysis::remove_non_argument_promise(prom_id_t prom_id) {
-    return non_argument_promises_.erase(prom_id);
-}
-
-inline bool
-PromiseTypeAnalysis::is_default_argument_promise(prom_id_t prom_id) {
-    return (default_argument_promises_.find(prom_id) !=
-            default_argument_promises_.end());
-}
-
-inline bool PromiseTypeAnalysis::is_custom_argument_promise(prom_id_t prom_id) {
-    return (custom_argument_promises_.find(prom_id) !=
-            custom_argument_promises_.end());
-}
-
-inline bool PromiseTypeAnalysis::is_non_argument_promise(prom_id_t prom_id) {
-    return (non_argument_promises_.find(prom_id) !=
-            non_argument_promises_.end());
+inline PromiseTypeAnalysis::PromiseCategory
+PromiseTypeAnalysis::get_category(prom_id_t prom_id) const {
+    if (prom_id < 0) {
+        auto iter = foreign_categories_.find(prom_id);
+        return iter == foreign_categories_.end() ? PromiseCategory::NONE
+                                                 : iter->second;
+    }
+    std::size_t index = prom_id / 4;
+    if (index >= categories_.size())
+        return PromiseCategory::NONE;
+    return static_cast<PromiseCategory>(
+        (categories_[index] >> (2 * (prom_id % 4))) & 0x3);
+}
+
+inline void PromiseTypeAnalysis::set_category(prom_id_t prom_id,
+                                              PromiseCategory category) {
+    if (prom_id < 0) {
+        if (category == PromiseCategory::NONE)
+            foreign_categories_.erase(prom_id);
+        else
+            foreign_categories_[prom_id] = category;
+        return;
+    }
+    std::size_t index = prom_id / 4;
+    if (index >= categories_.size()) {
+        if (category == PromiseCategory::NONE)
+            return;
+        /* promise ids are allocated in increasing order, grow geometrically
+           to amortize the resizing. */
+        categories_.resize(std::max(index + 1, 2 * categories_.size()), 0);
+    }
+    int shift = 2 * (prom_id % 4);
+    categories_[index] = (categories_[index] & ~(0x3 << shift)) |
+                         (to_underlying_type(category) << shift);
 }
 
 void PromiseTypeAnalysis::promise_created(
     const prom_basic_info_t &prom_basic_info, const SEXP promise) {
-    add_non_argument_promise(prom_basic_info.prom_id);
+    set_category(prom_basic_info.prom_id, PromiseCategory::NON_ARGUMENT);
 }
 
 void PromiseTypeAnalysis::closure_entry(const closure_info_t &closure_info) {
     for (const auto &argument : closure_info.arguments) {
         prom_id_t promise_id = argument.promise_id;
-        int formal_parameter_position = argument.formal_parameter_position;
         auto parameter_mode = argument.parameter_mode;
+        PromiseCategory category = get_category(promise_id);
+        /* a promise passed both as a default and as a custom argument is
+           counted as a default argument. */
         if (parameter_mode == parameter_mode_t::DEFAULT)
-            add_default_argument_promise(promise_id);
-        else if (parameter_mode == parameter_mode_t::CUSTOM)
-            add_custom_argument_promise(promise_id);
-        remove_non_argument_promise(promise_id);
+            set_category(promise_id, PromiseCategory::DEFAULT_ARGUMENT);
+        else if (parameter_mode == parameter_mode_t::CUSTOM &&
+                 category != PromiseCategory::DEFAULT_ARGUMENT)
+            set_category(promise_id, PromiseCategory::CUSTOM_ARGUMENT);
+        else if (category == PromiseCategory::NON_ARGUMENT)
+            set_category(promise_id, PromiseCategory::NONE);
     }
 }
 
 void PromiseTypeAnalysis::promise_force_exit(const prom_info_t &prom_info,
                                              const SEXP promise) {
-
-    if (is_default_argument_promise(prom_info.prom_id)) {
-        ++default_argument_promise_types_[TYPEOF(PRCODE(promise))]
-                                         [TYPEOF(PRVALUE(promise))];
-        remove_default_argument_promise(prom_info.prom_id);
-    } else if (is_custom_argument_promise(prom_info.prom_id)) {
-        ++custom_argument_promise_types_[TYPEOF(PRCODE(promise))]
-                                        [TYPEOF(PRVALUE(promise))];
-        remove_custom_argument_promise(prom_info.prom_id);
-    } else if (is_non_argument_promise(prom_info.prom_id)) {
-        ++non_argument_promise_types_[TYPEOF(PRCODE(promise))]
-                                     [TYPEOF(PRVALUE(promise))];
-        remove_non_argument_promise(prom_info.prom_id);
+    /* the recorder has already read the types of the expression and of
+       the value of the promise, they are not read again. */
+    sexptype_t expression_type = prom_info.prom_type;
+    sexptype_t value_type = prom_info.return_type;
+
+    switch (get_category(prom_info.prom_id)) {
+        case PromiseCategory::DEFAULT_ARGUMENT:
+            ++default_argument_promise_types_[expression_type][value_type];
+            break;
+        case PromiseCategory::CUSTOM_ARGUMENT:
+            ++custom_argument_promise_types_[expression_type][value_type];
+            break;
+        case PromiseCategory::NON_ARGUMENT:
+            ++non_argument_promise_types_[expression_type][value_type];
+            break;
+        case PromiseCategory::NONE:
+            return;
     }
+    set_category(prom_info.prom_id, PromiseCategory::NONE);
 }
 
 void PromiseTypeAnalysis::gc_promise_unmarked(prom_id_t promise_id,
                                               const SEXP promise) {
-    if (is_default_argument_promise(promise_id)) {
-        add_unevaluated_promise("da", promise);
-        remove_default_argument_promise(promise_id);
-    } else if (is_custom_argument_promise(promise_id)) {
-        add_unevaluated_promise("ca", promise);
-        remove_custom_argument_promise(promise_id);
-    } else if (is_non_argument_promise(promise_id)) {
-        add_unevaluated_promise("na", promise);
-        remove_non_argument_promise(promise_id);
+    switch (get_category(promise_id)) {
+        case PromiseCategory::DEFAULT_ARGUMENT:
+            add_unevaluated_promise("da", promise);
+            break;
+        case PromiseCategory::CUSTOM_ARGUMENT:
+            add_unevaluated_promise("ca", promise);
+            break;
+        case PromiseCategory::NON_ARGUMENT:
+            add_unevaluated_promise("na", promise);
+            break;
+        case PromiseCategory::NONE:
+            return;
     }
+    set_category(promise_id, PromiseCategory::NONE);
 }
 
 void PromiseTypeAnalysis::end(dyntracer_t *dyntracer) { serialize(); }
 
+void PromiseTypeAnalysis::account_memory(MemoryAccount &account) const {
+    account.add("promise_type_analysis/categories",
+                4 * categories_.size() + foreign_categories_.size(),
+                approximate_memory_size(categories_) +
+                    approximate_memory_size(foreign_categories_));
+    std::size_t unevaluated_bytes =
+        approximate_memory_size(unevaluated_promises_);
+    for (const auto &key_value : unevaluated_promises_) {
+        unevaluated_bytes += approximate_memory_size(key_value.first);
+    }
+    account.add("promise_type_analysis/unevaluated_promises",
+                unevaluated_promises_.size(), unevaluated_bytes);
+}
+
 void PromiseTypeAnalysis::add_unevaluated_promise(
     const std::string promise_type, SEXP promise) {
     std::string key = promise_type + " , " +
@@ -1,11 +1,21 @@
 #ifndef __PROMISE_TYPE_ANALYSIS_H__
 #define __PROMISE_TYPE_ANALYSIS_H__
 
+#include "MemoryAccount.h"
 #include "State.h"
 #include "utilities.h"
+#include <cstdint>
+#include <vector>
 
 class PromiseTypeAnalysis {
   public:
+    enum class PromiseCategory : std::uint8_t {
+        NONE = 0,
+        NON_ARGUMENT,
+        CUSTOM_ARGUMENT,
+        DEFAULT_ARGUMENT
+    };
+
     PromiseTypeAnalysis(const tracer_state_t &tracer_state,
                         const std::string &output_dir);
     void promise_created(const prom_basic_info_t &prom_basic_info,
@@ -13,28 +23,24 @@ class PromiseTypeAnalysis {
     void closure_entry(const closure_info_t &closure_info);
     void promise_force_exit(const prom_info_t &prom_info, const SEXP promise);
     void gc_promise_unmarked(prom_id_t prom_id, const SEXP promise);
-    inline bool add_default_argument_promise(prom_id_t prom_id);
-    inline bool add_custom_argument_promise(prom_id_t prom_id);
-    inline bool add_non_argument_promise(prom_id_t prom_id);
-    inline size_t remove_default_argument_promise(prom_id_t prom_id);
-    inline size_t remove_custom_argument_promise(prom_id_t prom_id);
-    inline size_t remove_non_argument_promise(prom_id_t prom_id);
-    inline bool is_default_argument_promise(prom_id_t prom_id);
-    inline bool is_custom_argument_promise(prom_id_t prom_id);
-    inline bool is_non_argument_promise(prom_id_t prom_id);
     void end(dyntracer_t *dyntracer);
+    void account_memory(MemoryAccount &account) const;
 
   private:
     void serialize();
     void serialize_evaluated_promises();
     void serialize_unevaluated_promises();
     void add_unevaluated_promise(const std::string promise_type, SEXP promise);
+    inline PromiseCategory get_category(prom_id_t prom_id) const;
+    inline void set_category(prom_id_t prom_id, PromiseCategory category);
 
     std::string output_dir_;
     const tracer_state_t &tracer_state_;
-    std::set<prom_id_t> default_argument_promises_;
-    std::set<prom_id_t> custom_argument_promises_;
-    std::set<prom_id_t> non_argument_promises_;
+    /* categories of promises with positive ids, packed four to a byte and
+       indexed by promise id. Foreign promises have negative ids and are
+       kept in a separate map. */
+    std::vector<std::uint8_t> categories_;
+    std::unordered_map<prom_id_t, PromiseCategory> foreign_categories_;
     int default_argument_promise_types_[MAX_NUM_SEXPTYPE][MAX_NUM_SEXPTYPE];
     int custom_argument_promise_types_[MAX_NUM_SEXPTYPE][MAX_NUM_SEXPTYPE];
     int non_argument_promise_types_[MAX_NUM_SEXPTYPE][MAX_NUM_SEXPTYPE];
@@ -11,18 +11,21 @@ SideEffectAnalysis::SideEffectAnalysis(tracer_state_t &tracer_state,
                                        const std::string &output_dir,
                                        bool truncate, bool binary,
                                        int compression_level)
-    : tracer_state_(tracer_state), output_dir_(output_dir),
+    : promise_timestamps_{std::numeric_limits<timestamp_t>::max(), true},
+      variable_timestamps_{std::numeric_limits<timestamp_t>::max(), true},
       defines_{std::vector<long long int>(3)},
       assigns_{std::vector<long long int>(3)},
       removals_{std::vector<long long int>(3)},
-      lookups_{std::vector<long long int>(3)}, timestamp_{0},
+      lookups_{std::vector<long long int>(3)}, output_dir_(output_dir),
+      timestamp_{0}, tracer_state_(tracer_state),
       undefined_timestamp{std::numeric_limits<std::size_t>::max()},
-      observed_side_effects_data_table_{create_data_table(
-          output_dir + "/" + "observed-side-effects", {"scope", "count"},
-          truncate, binary, compression_level)},
+      collected_side_effect_observers_{0},
       caused_side_effects_data_table_{create_data_table(
           output_dir + "/" + "caused-side-effects",
-          {"scope", "action", "count"}, truncate, binary, compression_level)} {}
+          {"scope", "action", "count"}, truncate, binary, compression_level)},
+      observed_side_effects_data_table_{create_data_table(
+          output_dir + "/" + "observed-side-effects", {"scope", "count"},
+          truncate, binary, compression_level)} {}
 
 void SideEffectAnalysis::promise_created(
     const prom_basic_info_t &prom_basic_info, const SEXP promise) {
@@ -32,29 +35,44 @@ void SideEffectAnalysis::promise_created(
 void SideEffectAnalysis::environment_define_var(const SEXP symbol,
                                                 const SEXP value,
                                                 const SEXP rho) {
-    bool exists = false;
-    update_variable_timestamp_(
-        tracer_state_.to_variable_id(symbol, rho, exists));
-    environment_action(rho, defines_);
+    environment_define_var(CHAR(PRINTNAME(symbol)), rho);
 }
 
 void SideEffectAnalysis::environment_assign_var(const SEXP symbol,
                                                 const SEXP value,
                                                 const SEXP rho) {
-    bool exists = false;
-    update_variable_timestamp_(
-        tracer_state_.to_variable_id(symbol, rho, exists));
-    environment_action(rho, assigns_);
+    environment_assign_var(CHAR(PRINTNAME(symbol)), rho);
 }
 
 void SideEffectAnalysis::environment_remove_var(const SEXP symbol,
                                                 const SEXP rho) {
-    environment_action(rho, removals_);
+    environment_remove_var(CHAR(PRINTNAME(symbol)), rho);
 }
 
 void SideEffectAnalysis::environment_lookup_var(const SEXP symbol,
                                                 const SEXP value,
                                                 const SEXP rho) {
+    environment_lookup_var(CHAR(PRINTNAME(symbol)), rho);
+}
+
+void SideEffectAnalysis::environment_define_var(const std::string &symbol,
+                                                const SEXP rho) {
+    bool exists = false;
+    update_variable_timestamp_(
+        tracer_state_.to_variable_id(symbol, rho, exists));
+    environment_action(rho, defines_);
+}
+
+void SideEffectAnalysis::environment_assign_var(const std::string &symbol,
+                                                const SEXP rho) {
+    bool exists = false;
+    update_variable_timestamp_(
+        tracer_state_.to_variable_id(symbol, rho, exists));
+    environment_action(rho, assigns_);
+}
+
+void SideEffectAnalysis::environment_lookup_var(const std::string &symbol,
+                                                const SEXP rho) {
     // we process the action first.
     environment_action(rho, lookups_);
 
@@ -85,6 +103,11 @@ void SideEffectAnalysis::environment_lookup_var(const SEXP symbol,
     }
 }
 
+void SideEffectAnalysis::environment_remove_var(const std::string &symbol,
+                                                const SEXP rho) {
+    environment_action(rho, removals_);
+}
+
 void SideEffectAnalysis::environment_action(
     const SEXP rho, std::vector<long long int> &counter) {
     size_t stack_size = tracer_state_.full_stack.size();
@@ -108,8 +131,39 @@ void SideEffectAnalysis::environment_action(
     ++counter[SideEffectAnalysis::GLOBAL];
 }
 
+void SideEffectAnalysis::gc_promise_unmarked(const prom_id_t prom_id,
+                                             const SEXP promise) {
+    promise_timestamps_.erase(prom_id);
+    collected_side_effect_observers_ += side_effect_observers_.erase(prom_id);
+}
+
+void SideEffectAnalysis::gc_environment_unmarked(const SEXP rho) {
+    auto iter = tracer_state_.environments.find(rho);
+    if (iter == tracer_state_.environments.end())
+        return;
+    for (const auto &variable : iter->second.second) {
+        variable_timestamps_.erase(variable.second);
+    }
+}
+
 void SideEffectAnalysis::end(dyntracer_t *dyntracer) { serialize(); }
 
+void SideEffectAnalysis::account_memory(MemoryAccount &account) const {
+    account.add("side_effect_analysis/promise_timestamps",
+                promise_timestamps_.size(),
+                promise_timestamps_.get_memory_size());
+    account.add("side_effect_analysis/variable_timestamps",
+                variable_timestamps_.size(),
+                variable_timestamps_.get_memory_size());
+    account.add("side_effect_analysis/side_effect_observers",
+                side_effect_observers_.size(),
+                approximate_memory_size(side_effect_observers_));
+    account.add_table("side_effect_analysis/caused-side-effects",
+                      caused_side_effects_data_table_);
+    account.add_table("side_effect_analysis/observed-side-effects",
+                      observed_side_effects_data_table_);
+}
+
 SideEffectAnalysis::~SideEffectAnalysis() {
     delete observed_side_effects_data_table_;
     delete caused_side_effects_data_table_;
@@ -126,7 +180,8 @@ void SideEffectAnalysis::serialize() {
     }
 
     observed_side_effects_data_table_->write_row(
-        "promise", (double)side_effect_observers_.size());
+        "promise", (double)(side_effect_observers_.size() +
+                            collected_side_effect_observers_));
 }
 
 timestamp_t SideEffectAnalysis::get_timestamp_() const { return timestamp_; }
@@ -134,25 +189,17 @@ timestamp_t SideEffectAnalysis::get_timestamp_() const { return timestamp_; }
 timestamp_t SideEffectAnalysis::update_timestamp_() { return timestamp_++; }
 
 void SideEffectAnalysis::update_promise_timestamp_(prom_id_t promise_id) {
-    promise_timestamps_[promise_id] = update_timestamp_();
+    promise_timestamps_.set(promise_id, update_timestamp_());
 }
 
 void SideEffectAnalysis::update_variable_timestamp_(var_id_t variable_id) {
-    variable_timestamps_[variable_id] = update_timestamp_();
+    variable_timestamps_.set(variable_id, update_timestamp_());
 }
 
 timestamp_t SideEffectAnalysis::get_promise_timestamp_(prom_id_t promise_id) {
-    auto iter = promise_timestamps_.find(promise_id);
-    if (iter == promise_timestamps_.end()) {
-        return undefined_timestamp;
-    }
-    return iter->second;
+    return promise_timestamps_.get(promise_id);
 }
 
 timestamp_t SideEffectAnalysis::get_variable_timestamp_(var_id_t variable_id) {
-    auto iter = variable_timestamps_.find(variable_id);
-    if (iter == variable_timestamps_.end()) {
-        return undefined_timestamp;
-    }
-    return iter->second;
+    return variable_timestamps_.get(variable_id);
 }
@@ -2,7 +2,9 @@
 #define __SIDE_EFFECT_ANALYSIS_H__
 
 #include "CallState.h"
+#include "DenseIdMap.h"
 #include "FunctionState.h"
+#include "MemoryAccount.h"
 #include "PromiseState.h"
 #include "State.h"
 #include "table.h"
@@ -33,9 +35,18 @@ class SideEffectAnalysis {
     void environment_remove_var(const SEXP symbol, const SEXP rho);
     void environment_lookup_var(const SEXP symbol, const SEXP value,
                                 const SEXP rho);
+    /* the symbol is only needed by name and the environment only as a key,
+       so these can be driven without R objects. */
+    void environment_define_var(const std::string &symbol, const SEXP rho);
+    void environment_assign_var(const std::string &symbol, const SEXP rho);
+    void environment_lookup_var(const std::string &symbol, const SEXP rho);
+    void environment_remove_var(const std::string &symbol, const SEXP rho);
     void environment_action(const SEXP rho,
                             std::vector<long long int> &counter);
+    void gc_promise_unmarked(const prom_id_t prom_id, const SEXP promise);
+    void gc_environment_unmarked(const SEXP rho);
     void end(dyntracer_t *dyntracer);
+    void account_memory(MemoryAccount &account) const;
 
     ~SideEffectAnalysis();
 
@@ -47,8 +58,8 @@ class SideEffectAnalysis {
     void update_variable_timestamp_(var_id_t variable_id);
     timestamp_t get_promise_timestamp_(prom_id_t promise_id);
     timestamp_t get_variable_timestamp_(var_id_t variable_id);
-    std::unordered_map<prom_id_t, timestamp_t> promise_timestamps_;
-    std::unordered_map<var_id_t, timestamp_t> variable_timestamps_;
+    DenseIdMap<timestamp_t> promise_timestamps_;
+    DenseIdMap<timestamp_t> variable_timestamps_;
     std::vector<long long int> defines_;
     std::vector<long long int> assigns_;
     std::vector<long long int> removals_;
@@ -57,7 +68,10 @@ class SideEffectAnalysis {
     timestamp_t timestamp_;
     tracer_state_t &tracer_state_;
     const timestamp_t undefined_timestamp;
+    /* observers which are still alive, the collected ones are only
+       counted. */
     std::unordered_set<prom_id_t> side_effect_observers_;
+    std::size_t collected_side_effect_observers_;
     DataTableStream *caused_side_effects_data_table_;
     DataTableStream *observed_side_effects_data_table_;
 };
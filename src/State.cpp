@@ -1,10 +1,67 @@
 #include "State.h"
+#include "MemoryAccount.h"
 #include "TraceSerializer.h"
 #include "utilities.h"
 
+void tracer_state_t::account_memory(MemoryAccount &account) const {
+    account.add("tracer_state/full_stack", full_stack.size(),
+                approximate_memory_size(full_stack) +
+                    approximate_memory_size(full_stack_counts));
+    account.add("tracer_state/environment_stack_depths",
+                environment_stack_depths.size(),
+                environment_stack_depths.get_memory_size());
+    account.add("tracer_state/promise_origin", promise_origin.size(),
+                promise_origin.get_memory_size());
+    account.add("tracer_state/fresh_promises", fresh_promises.size(),
+                approximate_memory_size(fresh_promises));
+    account.add("tracer_state/promise_ids", promise_ids.size(),
+                approximate_memory_size(promise_ids));
+    account.add("tracer_state/promise_lookup_gc_trigger_counter",
+                promise_lookup_gc_trigger_counter.size(),
+                promise_lookup_gc_trigger_counter.get_memory_size());
+
+    std::size_t definition_bytes =
+        approximate_memory_size(function_definitions);
+    for (const auto &definition : function_definitions) {
+        definition_bytes += approximate_memory_size(definition.second);
+    }
+    account.add("tracer_state/function_definitions",
+                function_definitions.size(), definition_bytes);
+
+    std::size_t function_id_bytes = approximate_memory_size(function_ids);
+    for (const auto &function_id : function_ids) {
+        function_id_bytes += approximate_memory_size(function_id.first) +
+                             approximate_memory_size(function_id.second);
+    }
+    account.add("tracer_state/function_ids", function_ids.size(),
+                function_id_bytes);
+
+    account.add("tracer_state/already_inserted_functions",
+                already_inserted_functions.size(),
+                approximate_memory_size(already_inserted_functions));
+    account.add("tracer_state/argument_ids", argument_ids.size(),
+                approximate_memory_size(argument_ids));
+
+    std::size_t variable_count = 0;
+    std::size_t variable_bytes = 0;
+    for (const auto &environment : environments) {
+        const auto &variables = environment.second.second;
+        variable_count += variables.size();
+        variable_bytes += approximate_memory_size(variables);
+        for (const auto &variable : variables) {
+            variable_bytes += approximate_memory_size(variable.first);
+        }
+    }
+    account.add("tracer_state/environments", environments.size(),
+                approximate_memory_size(environments));
+    account.add("tracer_state/environment_variables", variable_count,
+                variable_bytes);
+}
+
 void tracer_state_t::finish_pass() { promise_origin.clear(); }
 
-tracer_state_t::tracer_state_t() {
+tracer_state_t::tracer_state_t()
+    : promise_origin{0, true}, promise_lookup_gc_trigger_counter{0, true} {
     call_id_counter = 0;
     fn_id_counter = 0;
     prom_id_counter = 0;
@@ -13,6 +70,8 @@ tracer_state_t::tracer_state_t() {
     gc_trigger_counter = 0;
     environment_id_counter = 0;
     variable_id_counter = 0;
+    primitive_fast_path = false;
+    full_promise_type = false;
 }
 
 void tracer_state_t::increment_gc_trigger_counter() { gc_trigger_counter++; }
@@ -75,6 +134,61 @@ prom_id_t tracer_state_t::enclosing_promise_id() {
     return -1;
 }
 
+void tracer_state_t::push_stack(const stack_event_t &event) {
+    stack_frame_counts_t counts{0, 0, 0, 0, -1};
+    if (!full_stack_counts.empty()) {
+        counts = full_stack_counts.back();
+        counts.previous_environment_depth = -1;
+    }
+
+    if (event.type == stack_type::CALL) {
+        if (event.function_info.type == function_type::CLOSURE)
+            ++counts.closure;
+        else if (event.function_info.type == function_type::SPECIAL)
+            ++counts.special;
+        else
+            ++counts.builtin;
+
+        counts.previous_environment_depth = environment_stack_depths.exchange(
+            event.enclosing_environment, full_stack.size());
+    } else if (event.type == stack_type::PROMISE) {
+        ++counts.promise;
+    }
+
+    full_stack.push_back(event);
+    full_stack_counts.push_back(counts);
+}
+
+void tracer_state_t::pop_stack() {
+    const stack_event_t &event = full_stack.back();
+
+    if (event.type == stack_type::CALL) {
+        int previous_depth =
+            full_stack_counts.back().previous_environment_depth;
+        if (previous_depth == -1)
+            environment_stack_depths.erase(event.enclosing_environment);
+        else
+            environment_stack_depths.exchange(event.enclosing_environment,
+                                              previous_depth);
+    }
+
+    full_stack.pop_back();
+    full_stack_counts.pop_back();
+}
+
+void tracer_state_t::clear_stack() {
+    full_stack.clear();
+    full_stack_counts.clear();
+    environment_stack_depths.clear();
+    call_sampler.pop_to(0);
+}
+
+// This function returns -1 if no call frame on the stack has the given
+// enclosing environment.
+int tracer_state_t::get_environment_stack_depth(env_addr_t environment) const {
+    return environment_stack_depths.get(environment);
+}
+
 static stack_event_t make_dummy_stack_event() {
     stack_event_t dummy_event;
     dummy_event.type = stack_type::NONE;
@@ -83,19 +197,22 @@ static stack_event_t make_dummy_stack_event() {
     return dummy_event;
 }
 
-// TODO return pointer?
-stack_event_t get_last_on_stack_by_type(vector<stack_event_t> &stack,
-                                        stack_type type) {
+/* returned when no frame matches, so that lookups do not copy frames */
+static const stack_event_t dummy_stack_event = make_dummy_stack_event();
+
+const stack_event_t &get_last_on_stack_by_type(vector<stack_event_t> &stack,
+                                               stack_type type) {
     for (vector<stack_event_t>::reverse_iterator i = stack.rbegin();
          i != stack.rend(); ++i)
         if (type == i->type)
             return *i;
 
-    return make_dummy_stack_event();
+    return dummy_stack_event;
 }
 
-stack_event_t get_from_back_of_stack_by_type(vector<stack_event_t> &stack,
-                                             stack_type type, int rposition) {
+const stack_event_t &
+get_from_back_of_stack_by_type(vector<stack_event_t> &stack, stack_type type,
+                               int rposition) {
     int rindex = rposition;
     for (vector<stack_event_t>::reverse_iterator i = stack.rbegin();
          i != stack.rend(); ++i)
@@ -106,5 +223,5 @@ stack_event_t get_from_back_of_stack_by_type(vector<stack_event_t> &stack,
                 rindex--;
         }
 
-    return make_dummy_stack_event();
+    return dummy_stack_event;
 }
@@ -1,6 +1,14 @@
 #ifndef PROMISEDYNTRACER_STATE_H
 #define PROMISEDYNTRACER_STATE_H
 
+#include "CallDegrader.h"
+#include "CallFilter.h"
+#include "CallSampler.h"
+#include "DenseIdMap.h"
+#include "EnvironmentDepthMap.h"
+#include "InfoPool.h"
+#include "LocationCache.h"
+#include "PrimitiveCounters.h"
 #include "sexptypes.h"
 #include "stdlibs.h"
 
@@ -92,11 +100,29 @@ struct stack_event_t {
     env_addr_t enclosing_environment;
     // Only initialized for type == CALL
     struct {
-        fn_id_t function_id;
+        // Interned in tracer_state_t::function_ids, so that pushing a frame
+        // does not copy the id
+        const fn_id_t *function_id = nullptr;
         function_type type;
     } function_info;
 };
 
+class MemoryAccount;
+
+/* Running frame counts of the full stack. The counts of a frame include the
+   frame itself and all the frames below it, so the number of frames of each
+   kind above a frame is the difference between its counts and those of the
+   top of the stack. */
+struct stack_frame_counts_t {
+    std::uint32_t closure;
+    std::uint32_t special;
+    std::uint32_t builtin;
+    std::uint32_t promise;
+    /* depth of the next call frame below with the same enclosing
+       environment, -1 if there is none. */
+    int previous_environment_depth;
+};
+
 typedef map<std::string, std::string> metadata_t;
 
 struct call_stack_elem_t {
@@ -117,10 +143,12 @@ typedef prom_addr_t prom_key_t;
 struct call_info_t {
     function_type fn_type;
     fn_id_t fn_id;
+    // Same id, interned for the lifetime of the tracer state
+    const fn_id_t *interned_fn_id;
     SEXP fn_addr; // TODO unnecessary?
     string fn_definition;
-    string definition_location;
-    string callsite_location;
+    location_id_t definition_location_id;
+    location_id_t callsite_location_id;
     bool fn_compiled;
 
     string name; // fully qualified function name, if available
@@ -147,6 +175,8 @@ struct builtin_info_t : call_info_t {};
 // FIXME would it make sense to add type of action here?
 struct prom_basic_info_t {
     prom_id_t prom_id;
+    /* environment of the promise, only used as a key */
+    SEXP promise_environment;
 
     sexptype_t prom_type;
     full_sexp_type full_type;
@@ -184,11 +214,15 @@ prom_id_t get_promise_id(dyntracer_t *dyntracer, SEXP promise);
 prom_id_t make_promise_id(dyntracer_t *dyntracer, SEXP promise,
                           bool negative = false);
 call_id_t make_funcall_id(dyntracer_t *dyntracer, SEXP);
-string get_function_definition(dyntracer_t *dyntracer, const SEXP function);
+const string &get_function_definition(dyntracer_t *dyntracer,
+                                     const SEXP function);
 void remove_function_definition(dyntracer_t *dyntracer, const SEXP function);
-fn_id_t get_function_id(dyntracer_t *dyntracer, const string &def,
-                        bool builtin = false);
+const fn_id_t &get_function_id(dyntracer_t *dyntracer, const string &def,
+                               bool builtin = false);
 fn_addr_t get_function_addr(SEXP func);
+location_id_t get_definition_location_id(dyntracer_t *dyntracer, SEXP op);
+location_id_t get_callsite_location_id(dyntracer_t *dyntracer,
+                                       int how_far_in_the_past);
 
 // Returns false if function already existed, true if it was registered now
 bool register_inserted_function(dyntracer_t *dyntracer, fn_id_t id);
@@ -205,7 +239,7 @@ void get_stack_parent(T &info, vector<stack_event_t> &stack) {
                   "prom_basic_info_t,  prom_info_t, or call_info_t.");
 
     if (!stack.empty()) {
-        stack_event_t stack_elem = stack.back();
+        const stack_event_t &stack_elem = stack.back();
         // parent type
         info.parent_on_stack.type = stack_elem.type;
         switch (info.parent_on_stack.type) {
@@ -234,7 +268,7 @@ void get_stack_parent2(T &info, vector<stack_event_t> &stack) {
                   "prom_basic_info_t,  prom_info_t, or call_info_t.");
 
     if (stack.size() > 1) {
-        stack_event_t stack_elem = stack.rbegin()[1];
+        const stack_event_t &stack_elem = stack.rbegin()[1];
         info.parent_on_stack.type = stack_elem.type;
         switch (info.parent_on_stack.type) {
             case stack_type::PROMISE:
@@ -252,10 +286,11 @@ void get_stack_parent2(T &info, vector<stack_event_t> &stack) {
     }
 }
 
-stack_event_t get_last_on_stack_by_type(vector<stack_event_t> &stack,
-                                        stack_type type);
-stack_event_t get_from_back_of_stack_by_type(vector<stack_event_t> &stack,
-                                             stack_type type, int rposition);
+const stack_event_t &get_last_on_stack_by_type(vector<stack_event_t> &stack,
+                                               stack_type type);
+const stack_event_t &
+get_from_back_of_stack_by_type(vector<stack_event_t> &stack, stack_type type,
+                               int rposition);
 
 prom_id_t get_parent_promise(dyntracer_t *dyntracer);
 arg_id_t get_argument_id(dyntracer_t *dyntracer, call_id_t call_id,
@@ -273,14 +308,18 @@ string recursive_type_to_string(recursion_type);
 
 struct tracer_state_t {
     vector<stack_event_t> full_stack; // Should be reset on each tracer pass
+    // Maintained alongside full_stack by push_stack and pop_stack
+    vector<stack_frame_counts_t> full_stack_counts;
+    // Map from enclosing environment to the depth of its topmost call frame
+    EnvironmentDepthMap environment_stack_depths;
 
     // Map from promise IDs to call IDs
-    unordered_map<prom_id_t, call_id_t>
-        promise_origin; // Should be reset on each tracer pass
+    DenseIdMap<call_id_t> promise_origin; // Should be reset on each tracer
+                                          // pass
     unordered_set<prom_id_t> fresh_promises;
     // Map from promise address to promise ID;
     unordered_map<prom_addr_t, prom_id_t> promise_ids;
-    unordered_map<prom_id_t, int> promise_lookup_gc_trigger_counter;
+    DenseIdMap<int> promise_lookup_gc_trigger_counter;
     env_id_t environment_id_counter;
     var_id_t variable_id_counter;
     call_id_t call_id_counter; // IDs assigned should be globally unique but we
@@ -313,6 +352,21 @@ struct tracer_state_t {
     map<arg_key_t, arg_id_t> argument_ids; // Should be kept across Rdt calls
                                            // (unless overwrite is true)
     int gc_trigger_counter; // Incremented each time there is a gc_entry
+    CallFilter call_filter;
+    CallDegrader call_degrader;
+    PrimitiveCounters primitive_counters;
+    LocationCache locations;
+    // Builtin and special calls only push a frame when no consumer needs
+    // their full info
+    bool primitive_fast_path;
+    // The full type of promises is only inferred when a consumer needs it
+    bool full_promise_type;
+    CallSampler call_sampler;
+    // Reused by the recorder across probes
+    InfoPool<closure_info_t> closure_infos;
+    InfoPool<builtin_info_t> builtin_infos;
+    InfoPool<prom_basic_info_t> promise_basic_infos;
+    InfoPool<prom_info_t> promise_infos;
 
     std::unordered_map<
         SEXP, std::pair<env_id_t, std::unordered_map<std::string, var_id_t>>>
@@ -323,6 +377,11 @@ struct tracer_state_t {
     var_id_t to_variable_id(SEXP symbol, SEXP rho, bool &exists);
     var_id_t to_variable_id(const std::string &symbol, SEXP rho, bool &exists);
     prom_id_t enclosing_promise_id();
+    void push_stack(const stack_event_t &event);
+    void pop_stack();
+    void clear_stack();
+    int get_environment_stack_depth(env_addr_t environment) const;
+    void account_memory(MemoryAccount &account) const;
     void remove_environment(const SEXP rho);
     void increment_gc_trigger_counter();
 
@@ -6,17 +6,30 @@ StrictnessAnalysis::StrictnessAnalysis(const tracer_state_t &tracer_state,
                                        PromiseMapper *const promise_mapper,
                                        const std::string &output_dir,
                                        bool truncate, bool binary,
-                                       int compression_level)
-    : tracer_state_(tracer_state), output_dir_(output_dir),
-      promise_mapper_(promise_mapper),
-      functions_(std::unordered_map<fn_id_t, FunctionState>(
-          FUNCTION_MAPPING_BUCKET_SIZE)) {
-
-    usage_data_table_ = create_data_table(
-        output_dir + "/" + "parameter-usage-count",
-        {"function_id", "call_id", "position", "parameter_mode",
-         "argument_type", "force", "lookup", "metaprogram"},
-        truncate, binary, compression_level);
+                                       int compression_level,
+                                       bool aggregate_parameter_usage)
+    : functions_(std::unordered_map<fn_id_t, FunctionState>(
+          FUNCTION_MAPPING_BUCKET_SIZE)),
+      tracer_state_(tracer_state), promise_mapper_(promise_mapper),
+      output_dir_(output_dir),
+      aggregate_parameter_usage_(aggregate_parameter_usage) {
+
+    /* In aggregated mode, the parameter uses of all calls are accumulated
+       per function and written once at the end instead of one row per
+       parameter per call. */
+    if (aggregate_parameter_usage_) {
+        usage_data_table_ = create_data_table(
+            output_dir + "/" + "parameter-usage-histogram",
+            {"function_id", "position", "parameter_mode", "argument_type",
+             "force", "lookup", "metaprogram", "count"},
+            truncate, binary, compression_level);
+    } else {
+        usage_data_table_ = create_data_table(
+            output_dir + "/" + "parameter-usage-count",
+            {"function_id", "call_id", "position", "parameter_mode",
+             "argument_type", "force", "lookup", "metaprogram"},
+            truncate, binary, compression_level);
+    }
 
     order_data_table_ = create_data_table(
         output_dir + "/" + "parameter-force-order",
@@ -56,7 +69,7 @@ void StrictnessAnalysis::context_jump(const unwind_info_t &info) {
         if (element.type == stack_type::CALL &&
             element.function_info.type == function_type::CLOSURE) {
             remove_stack_frame(element.call_id,
-                               element.function_info.function_id);
+                               *element.function_info.function_id);
         }
     }
 }
@@ -77,6 +90,12 @@ void StrictnessAnalysis::remove_stack_frame(call_id_t call_id, fn_id_t fn_id) {
     }
 
     it->second.add_order(call_state.get_order());
+
+    if (aggregate_parameter_usage_) {
+        it->second.add_parameter_uses(call_state.get_parameter_uses());
+    } else {
+        serialize_parameter_usage_count(call_state);
+    }
 }
 
 void StrictnessAnalysis::push_on_call_stack(CallState call_state) {
@@ -93,7 +112,6 @@ CallState StrictnessAnalysis::pop_from_call_stack(call_id_t call_id) {
         exit(EXIT_FAILURE);
     }
 
-    serialize_parameter_usage_count(call_state);
     return call_state;
 }
 
@@ -104,7 +122,40 @@ StrictnessAnalysis::~StrictnessAnalysis() {
     delete order_data_table_;
 }
 
-void StrictnessAnalysis::serialize() { serialize_parameter_usage_order(); }
+void StrictnessAnalysis::account_memory(MemoryAccount &account) const {
+    std::size_t function_bytes = approximate_memory_size(functions_);
+    std::size_t order_count = 0;
+    for (const auto &pair : functions_) {
+        const FunctionState &function_state = pair.second;
+        function_bytes +=
+            approximate_memory_size(pair.first) +
+            approximate_memory_size(function_state.get_order_counts()) +
+            approximate_memory_size(function_state.get_parameter_use_counts());
+        function_bytes +=
+            approximate_memory_size(
+                function_state.get_default_parameter_uses()) +
+            approximate_memory_size(function_state.get_custom_parameter_uses());
+        for (const auto &parameter_use_counts :
+             function_state.get_parameter_use_counts()) {
+            function_bytes += approximate_memory_size(parameter_use_counts);
+        }
+        order_count += function_state.get_order_counts().size();
+    }
+    account.add("strictness_analysis/functions", functions_.size(),
+                function_bytes);
+    account.add("strictness_analysis/orders", order_count, 0);
+    account.add("strictness_analysis/call_stack", call_stack_.size(),
+                approximate_memory_size(call_stack_));
+    account.add_table("strictness_analysis/usage-table", usage_data_table_);
+    account.add_table("strictness_analysis/order-table", order_data_table_);
+}
+
+void StrictnessAnalysis::serialize() {
+    serialize_parameter_usage_order();
+    if (aggregate_parameter_usage_) {
+        serialize_parameter_usage_histogram();
+    }
+}
 
 void StrictnessAnalysis::serialize_parameter_usage_count(
     const CallState &call_state) {
@@ -125,14 +176,32 @@ void StrictnessAnalysis::serialize_parameter_usage_count(
     }
 }
 
+void StrictnessAnalysis::serialize_parameter_usage_histogram() {
+    for (auto const &pair : functions_) {
+        const auto &parameter_use_counts{
+            pair.second.get_parameter_use_counts()};
+        for (std::size_t position = 0;
+             position < parameter_use_counts.size(); ++position) {
+            for (const auto &use_count : parameter_use_counts[position]) {
+                const ParameterUse &parameter{use_count.first};
+                usage_data_table_->write_row(
+                    pair.first, static_cast<int>(position),
+                    parameter_mode_to_string(parameter.get_parameter_mode()),
+                    sexptype_to_string(parameter.get_type()),
+                    parameter.get_force(), parameter.get_lookup(),
+                    parameter.get_metaprogram(),
+                    static_cast<double>(use_count.second));
+            }
+        }
+    }
+}
+
 void StrictnessAnalysis::serialize_parameter_usage_order() {
     for (auto const &pair : functions_) {
         fn_id_t fn_id = pair.first;
-        const auto &orders_{pair.second.get_orders()};
-        const auto &order_counts_{pair.second.get_order_counts()};
-        for (std::size_t i = 0; i < orders_.size(); ++i) {
-            order_data_table_->write_row(fn_id, orders_[i],
-                                         (double)order_counts_[i]);
+        for (const auto &order_count : pair.second.get_order_counts()) {
+            order_data_table_->write_row(fn_id, order_count.first.to_string(),
+                                         (double)order_count.second);
         }
     }
 }
@@ -142,7 +211,7 @@ void StrictnessAnalysis::promise_force_entry(const prom_info_t &prom_info,
     PromiseState &promise_state{promise_mapper_->find(prom_info.prom_id)};
 
     /* if promise is not an argument, then don't process it. */
-    if (!promise_state.argument) {
+    if (!promise_state.is_argument()) {
         return;
     }
 
@@ -162,7 +231,7 @@ void StrictnessAnalysis::promise_value_lookup(const prom_info_t &prom_info,
     PromiseState &promise_state{promise_mapper_->find(prom_info.prom_id)};
 
     /* if promise is not an argument, then don't process it. */
-    if (!promise_state.argument) {
+    if (!promise_state.is_argument()) {
         return;
     }
 
@@ -204,7 +273,7 @@ void StrictnessAnalysis::metaprogram_(const prom_info_t &prom_info,
     PromiseState &promise_state{promise_mapper_->find(prom_info.prom_id)};
 
     /* if promise is not an argument, then don't process it. */
-    if (!promise_state.argument) {
+    if (!promise_state.is_argument()) {
         return;
     }
 
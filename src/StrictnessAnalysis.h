@@ -3,6 +3,7 @@
 
 #include "CallState.h"
 #include "FunctionState.h"
+#include "MemoryAccount.h"
 #include "PromiseMapper.h"
 #include "State.h"
 #include "table.h"
@@ -16,7 +17,8 @@ class StrictnessAnalysis {
     StrictnessAnalysis(const tracer_state_t &tracer_state,
                        PromiseMapper *const promise_mapper,
                        const std::string &output_dir, bool truncate,
-                       bool binary, int compression_level);
+                       bool binary, int compression_level,
+                       bool aggregate_parameter_usage);
     void closure_entry(const closure_info_t &closure_info);
     void closure_exit(const closure_info_t &closure_info);
     void promise_force_entry(const prom_info_t &prom_info, const SEXP promise);
@@ -34,6 +36,8 @@ class StrictnessAnalysis {
     void end(dyntracer_t *dyntracer);
     ~StrictnessAnalysis();
 
+    void account_memory(MemoryAccount &account) const;
+
   private:
     void push_on_call_stack(CallState call_state);
     CallState pop_from_call_stack(call_id_t call_id);
@@ -45,6 +49,7 @@ class StrictnessAnalysis {
     void serialize();
     void serialize_parameter_usage_order();
     void serialize_parameter_usage_count(const CallState &call_state);
+    void serialize_parameter_usage_histogram();
     void serialize_function_call_count();
     void serialize_evaluation_context_counts();
     void serialize_promise_slot_accesses();
@@ -58,6 +63,7 @@ class StrictnessAnalysis {
     PromiseMapper *const promise_mapper_;
     std::string output_dir_;
     std::vector<CallState> call_stack_;
+    bool aggregate_parameter_usage_;
     DataTableStream *usage_data_table_;
     DataTableStream *order_data_table_;
 };
@@ -1,37 +1,182 @@
 #ifdef DYNTRACE_ENABLE_TIMING
 
 #include "Timer.h"
+#include <algorithm>
+#include <thread>
 
 DEFINE_ENUM(TimerSegment, TIMER_SEGMENT_ENUM, timer_segment_name,
             timer_segment_value)
 
-void Timer::start() { start_time = std::chrono::high_resolution_clock::now(); }
+/* ticks of the time stamp counter per nanosecond, measured once over a
+   short interval of the monotonic clock */
+static double calibrate_ticks_per_nanosecond() {
+#if defined(__x86_64__) || defined(__i386__)
+    auto clock_start = std::chrono::steady_clock::now();
+    std::uint64_t ticks_start = __rdtsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::uint64_t ticks_end = __rdtsc();
+    auto clock_end = std::chrono::steady_clock::now();
+    double nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(clock_end -
+                                                             clock_start)
+            .count();
+    return nanoseconds > 0 ? (ticks_end - ticks_start) / nanoseconds : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+double Timer::ticks_to_nanoseconds(double ticks) {
+    static const double ticks_per_nanosecond = calibrate_ticks_per_nanosecond();
+    return ticks / ticks_per_nanosecond;
+}
 
-void Timer::reset() { start_time = std::chrono::high_resolution_clock::now(); }
+Timer::Timer(const std::string &name, bool count_events)
+    : name_(name), start_time_{0},
+      histograms_(TimerSegment::TIMER_SEGMENT_COUNT * BUCKET_COUNT, 0) {
+#ifdef DYNTRACE_ENABLE_PERF_COUNTERS
+    /* timers are never destroyed before the process exits, which closes the
+       counters */
+    perf_counters_ = count_events ? new PerfCounters() : nullptr;
+    std::fill(std::begin(perf_start_), std::end(perf_start_), 0);
+#endif
+    zero();
+    /* calibrate before the first probe rather than inside it */
+    ticks_to_nanoseconds(0);
+}
+
+void Timer::start() { reset(); }
+
+void Timer::reset() {
+#ifdef DYNTRACE_ENABLE_PERF_COUNTERS
+    if (perf_counters_ != nullptr)
+        perf_counters_->read(perf_start_);
+#endif
+    start_time_ = read_ticks();
+}
 
 void Timer::zero() {
-    for (int i = 0; i < TimerSegment::TIMER_SEGMENT_COUNT; i++)
-        timers[i] = 0;
+    std::fill(std::begin(timers_), std::end(timers_), 0);
+    std::fill(std::begin(maximums_), std::end(maximums_), 0);
+    std::fill(std::begin(occurrences_), std::end(occurrences_), 0);
+    std::fill(histograms_.begin(), histograms_.end(), 0);
+#ifdef DYNTRACE_ENABLE_PERF_COUNTERS
+    for (auto &counts : perf_counts_)
+        std::fill(std::begin(counts), std::end(counts), 0);
+#endif
 }
 
 void Timer::end_segment(TimerSegment segment) {
-    auto end_time = std::chrono::high_resolution_clock::now();
-    const long duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                              end_time - start_time)
-                              .count();
-    timers[segment] += duration;
-    occurrences[segment]++;
-    start_time = std::chrono::high_resolution_clock::now();
+    ticks_t end_time = read_ticks();
+    /* the counter may step back if the thread migrates between cores */
+    ticks_t duration = end_time > start_time_ ? end_time - start_time_ : 0;
+    timers_[segment] += duration;
+    maximums_[segment] = std::max(maximums_[segment], duration);
+    ++occurrences_[segment];
+    ++histograms_[segment * BUCKET_COUNT + get_bucket(duration)];
+#ifdef DYNTRACE_ENABLE_PERF_COUNTERS
+    if (perf_counters_ != nullptr) {
+        PerfCounters::counts_t perf_end;
+        perf_counters_->read(perf_end);
+        for (int counter = 0; counter < PerfCounters::COUNTER_COUNT;
+             ++counter) {
+            perf_counts_[segment][counter] +=
+                perf_end[counter] - perf_start_[counter];
+            perf_start_[counter] = perf_end[counter];
+        }
+        /* leave the cost of the read out of the next segment */
+        end_time = read_ticks();
+    }
+#endif
+    start_time_ = end_time;
+}
+
+Timer::ticks_t Timer::get_bucket_upper_bound(int bucket) {
+    if (bucket < SUB_BUCKET_COUNT)
+        return bucket;
+    int shift = bucket / SUB_BUCKET_COUNT - 1;
+    ticks_t lower = static_cast<ticks_t>(SUB_BUCKET_COUNT +
+                                         bucket % SUB_BUCKET_COUNT)
+                    << shift;
+    return lower + ((ticks_t{1} << shift) - 1);
+}
+
+std::uint64_t Timer::get_occurrences(TimerSegment segment) const {
+    return occurrences_[segment];
+}
+
+double Timer::get_total_nanoseconds(TimerSegment segment) const {
+    return ticks_to_nanoseconds(timers_[segment]);
+}
+
+double Timer::get_max_nanoseconds(TimerSegment segment) const {
+    return ticks_to_nanoseconds(maximums_[segment]);
+}
+
+double Timer::get_quantile_nanoseconds(TimerSegment segment,
+                                       double quantile) const {
+    std::uint64_t count = occurrences_[segment];
+    if (count == 0)
+        return 0;
+    std::uint64_t rank = std::max<std::uint64_t>(1, quantile * count + 0.5);
+    const std::uint64_t *histogram = &histograms_[segment * BUCKET_COUNT];
+    std::uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += histogram[bucket];
+        if (seen >= rank) {
+            return ticks_to_nanoseconds(
+                std::min(get_bucket_upper_bound(bucket), maximums_[segment]));
+        }
+    }
+    return get_max_nanoseconds(segment);
 }
 
 std::vector<std::pair<std::string, std::string>> Timer::stats() {
     std::vector<std::pair<std::string, std::string>> r;
 
     for (int i = 0; i < TimerSegment::TIMER_SEGMENT_COUNT; i++) {
+        TimerSegment segment = static_cast<TimerSegment>(i);
         r.push_back(std::make_pair(
-            "TIMER_" + name_ + "_" + timer_segment_name((TimerSegment)i),
-            std::to_string(timers[i]) + "/" + std::to_string(occurrences[i])));
+            "TIMER_" + name_ + "_" + timer_segment_name(segment),
+            std::to_string(static_cast<long>(get_total_nanoseconds(segment))) +
+                "/" + std::to_string(occurrences_[i])));
+    }
+
+#ifdef DYNTRACE_ENABLE_PERF_COUNTERS
+    if (perf_counters_ != nullptr) {
+        std::string status =
+            perf_counters_->is_available()
+                ? std::string("available")
+                : "unavailable: " + perf_counters_->get_error();
+        r.push_back(std::make_pair("PERF_" + name_, status));
+        std::string counter_names;
+        for (int counter = 0; counter < PerfCounters::COUNTER_COUNT;
+             ++counter) {
+            counter_names +=
+                (counter == 0 ? "" : "/") +
+                std::string(PerfCounters::get_counter_name(
+                    static_cast<PerfCounters::Counter>(counter)));
+        }
+        r.push_back(
+            std::make_pair("PERF_" + name_ + "_COUNTERS", counter_names));
+        for (int i = 0; perf_counters_->is_available() &&
+                        i < TimerSegment::TIMER_SEGMENT_COUNT;
+             i++) {
+            if (occurrences_[i] == 0)
+                continue;
+            std::string counts;
+            for (int counter = 0; counter < PerfCounters::COUNTER_COUNT;
+                 ++counter) {
+                counts += (counter == 0 ? "" : "/") +
+                          std::to_string(perf_counts_[i][counter]);
+            }
+            r.push_back(std::make_pair(
+                "PERF_" + name_ + "_" +
+                    timer_segment_name(static_cast<TimerSegment>(i)),
+                counts));
+        }
     }
+#endif
 
     return r;
 }
@@ -5,8 +5,15 @@
 
 #include "EnumFactory.h"
 #include <chrono>
+#include <cstdint>
 #include <string>
 #include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#ifdef DYNTRACE_ENABLE_PERF_COUNTERS
+#include "PerfCounters.h"
+#endif
 
 #define TIMER_SEGMENT_ENUM(XX)                                                 \
     XX(BEGIN_SETUP, = 0)                                                       \
@@ -124,13 +131,19 @@
     XX(GC_PROMISE_UNMARKED_ANALYSIS_PROMISE_MAPPER, )                          \
     XX(GC_PROMISE_UNMARKED_ANALYSIS_STRICTNESS, )                              \
     XX(GC_PROMISE_UNMARKED_ANALYSIS_PROMISE_TYPE, )                            \
+    XX(GC_PROMISE_UNMARKED_ANALYSIS_SIDE_EFFECT, )                             \
     XX(GC_PROMISE_UNMARKED_RECORD_KEEPING, )                                   \
                                                                                \
     XX(GC_FUNCTION_UNMARKED_RECORD_KEEPING, )                                  \
                                                                                \
+    XX(GC_ENVIRONMENT_UNMARKED_ANALYSIS, )                                     \
+    XX(GC_ENVIRONMENT_UNMARKED_ANALYSIS_SIDE_EFFECT, )                         \
+    XX(GC_ENVIRONMENT_UNMARKED_RECORD_KEEPING, )                               \
+                                                                               \
     XX(GC_ENTRY_RECORDER, )                                                    \
                                                                                \
     XX(GC_EXIT_RECORDER, )                                                     \
+    XX(GC_EXIT_ANALYSIS, )                                                     \
                                                                                \
     XX(VECTOR_ALLOC_RECORDER, )                                                \
     XX(VECTOR_ALLOC_ANALYSIS, )                                                \
@@ -169,21 +182,51 @@
 DECLARE_ENUM(TimerSegment, TIMER_SEGMENT_ENUM, timer_segment_name,
              timer_segment_value)
 
+/* Accumulates the time spent in each segment of the probes. Time is read
+   from the time stamp counter where the processor has one, and converted to
+   nanoseconds only when the statistics are reported, with a rate calibrated
+   once against the monotonic clock. Every segment keeps a log-linear
+   histogram of its durations, so the tail latency can be reported along
+   with the total. A segment ends where the next one begins, so the counter
+   is read only once per segment. When built with
+   DYNTRACE_ENABLE_PERF_COUNTERS, the main timer also accumulates hardware
+   performance counters per segment. Reading them is a system call, so the
+   wall times of such a build are inflated by that cost. */
 class Timer {
   public:
+    using ticks_t = std::uint64_t;
+
+    /* durations below 2^SUB_BUCKET_BITS ticks are counted exactly, longer
+       ones fall in 2^SUB_BUCKET_BITS buckets per power of two, which bounds
+       the relative error of the reported quantiles by 1/8. */
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr int BUCKET_COUNT =
+        (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
     void start();
     void reset();
     void zero();
     void end_segment(TimerSegment segment);
     std::vector<std::pair<std::string, std::string>> stats();
 
+    const std::string &get_name() const { return name_; }
+    std::uint64_t get_occurrences(TimerSegment segment) const;
+    double get_total_nanoseconds(TimerSegment segment) const;
+    double get_max_nanoseconds(TimerSegment segment) const;
+    /* upper estimate of the given quantile of the segment durations */
+    double get_quantile_nanoseconds(TimerSegment segment,
+                                    double quantile) const;
+
+    static double ticks_to_nanoseconds(double ticks);
+
     Timer(Timer const &) = delete;
     Timer(Timer &&) = delete;
     Timer &operator=(Timer const &) = delete;
     Timer &operator=(Timer &&) = delete;
 
     static Timer &main_timer() {
-        static Timer main_timer("MAIN");
+        static Timer main_timer("MAIN", true);
         return main_timer;
     }
 
@@ -198,12 +241,41 @@ class Timer {
     }
 
   private:
-    Timer(const std::string &name) : name_(name){};
+    Timer(const std::string &name, bool count_events = false);
+
+    static ticks_t read_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    static int get_bucket(ticks_t ticks) {
+        if (ticks < SUB_BUCKET_COUNT)
+            return ticks;
+        int exponent = 63 - __builtin_clzll(ticks);
+        int shift = exponent - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKET_COUNT +
+               ((ticks >> shift) & (SUB_BUCKET_COUNT - 1));
+    }
+
+    static ticks_t get_bucket_upper_bound(int bucket);
 
     std::string name_;
-    long timers[TimerSegment::TIMER_SEGMENT_COUNT] = {0};
-    long occurrences[TimerSegment::TIMER_SEGMENT_COUNT] = {0};
-    std::chrono::time_point<std::chrono::high_resolution_clock> start_time;
+    ticks_t start_time_;
+    ticks_t timers_[TimerSegment::TIMER_SEGMENT_COUNT];
+    ticks_t maximums_[TimerSegment::TIMER_SEGMENT_COUNT];
+    std::uint64_t occurrences_[TimerSegment::TIMER_SEGMENT_COUNT];
+    std::vector<std::uint64_t> histograms_;
+
+#ifdef DYNTRACE_ENABLE_PERF_COUNTERS
+    PerfCounters *perf_counters_;
+    PerfCounters::counts_t perf_start_;
+    PerfCounters::counts_t perf_counts_[TimerSegment::TIMER_SEGMENT_COUNT];
+#endif
 };
 
 #define MAIN_TIMER_RESET() Timer::main_timer().reset();
@@ -216,7 +288,7 @@ class Timer {
 #define RECORDER_TIMER_END_SEGMENT(segment_name)                               \
     Timer::recorder_timer().end_segment(TimerSegment::segment_name);
 
-#define ANALYSIS_TIMER_RESET() Timer::recorder_timer().reset();
+#define ANALYSIS_TIMER_RESET() Timer::analysis_timer().reset();
 
 #define ANALYSIS_TIMER_END_SEGMENT(segment_name)                               \
     Timer::analysis_timer().end_segment(TimerSegment::segment_name);
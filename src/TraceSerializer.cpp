@@ -1,5 +1,10 @@
 #include "TraceSerializer.h"
 
+/* https://stackoverflow.com/questions/8206387/using-non-printable-characters-as-a-delimiter-in-php
+ */
+const char RECORD_SEPARATOR = 0x1e;
+const char UNIT_SEPARATOR = 0x1f;
+
 const std::string TraceSerializer::OPCODE_FUNCTION_BEGIN = "fnb";
 const std::string TraceSerializer::OPCODE_FUNCTION_FINISH = "fnf";
 const std::string TraceSerializer::OPCODE_ARGUMENT_PROMISE_ASSOCIATE = "apa";
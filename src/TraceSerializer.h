@@ -1,10 +1,14 @@
 #ifndef __TRACE_SERIALIZER_H__
 #define __TRACE_SERIALIZER_H__
 
+#include "FileStream.h"
 #include "State.h"
 #include "stdlibs.h"
 #include "utilities.h"
 
+extern const char UNIT_SEPARATOR;
+extern const char RECORD_SEPARATOR;
+
 class TraceSerializer {
   public:
     static const std::string OPCODE_FUNCTION_BEGIN;
@@ -31,14 +35,16 @@ class TraceSerializer {
         open_trace(trace_filepath, truncate);
     }
 
-    template <typename T> void serialize(T value) {
+    /* the arguments are taken by reference, so that nothing is copied when
+       the trace is disabled */
+    template <typename T> void serialize(const T &value) {
         if (enable_trace()) {
             trace << value << RECORD_SEPARATOR << std::endl;
         }
     }
 
     template <typename T, typename... Args>
-    void serialize(T value, Args... args) {
+    void serialize(const T &value, const Args &... args) {
         if (enable_trace()) {
             trace << value << UNIT_SEPARATOR;
             serialize(args...);
@@ -47,6 +53,8 @@ class TraceSerializer {
 
     ~TraceSerializer() { close_trace(); }
 
+    bool enable_trace() const { return enable_trace_; }
+
   private:
     void open_trace(const std::string &trace_filepath, bool truncate) {
         if (!enable_trace())
@@ -55,17 +63,16 @@ class TraceSerializer {
             if (truncate)
                 remove(trace_filepath.c_str());
             else {
-                dyntrace_log_error("trace file '%s' already exists and "
-                                   "truncate flag is false",
-                                   trace_filepath.c_str());
+                failwith("trace file '%s' already exists and truncate flag "
+                         "is false\n",
+                         trace_filepath.c_str());
             }
         }
         trace.open(trace_filepath);
         if (!trace.good()) {
             close_trace();
-            dyntrace_log_error(
-                "invalid state of stream object associated with %s",
-                trace_filepath.c_str());
+            failwith("invalid state of stream object associated with %s\n",
+                     trace_filepath.c_str());
         }
     }
 
@@ -74,8 +81,6 @@ class TraceSerializer {
             trace.close();
     }
 
-    bool enable_trace() const { return enable_trace_; }
-
     std::string trace_filepath;
     std::ofstream trace;
     bool enable_trace_;
@@ -37,6 +37,10 @@ class ZstdCompressionStream : public Stream {
 
     int get_compression_level() const { return compression_level_; }
 
+    std::size_t get_buffer_capacity() const {
+        return input_buffer_size_ + output_buffer_size_;
+    }
+
     void write(const void *buffer, std::size_t bytes) override {
         const char *buf = static_cast<const char *>(buffer);
         std::size_t copied_bytes = 0;
@@ -50,7 +50,8 @@ prom_id_t make_promise_id(dyntracer_t *dyntracer, SEXP promise, bool negative) {
     return prom_id;
 }
 
-string get_function_definition(dyntracer_t *dyntracer, const SEXP function) {
+const string &get_function_definition(dyntracer_t *dyntracer,
+                                     const SEXP function) {
     auto &definitions = tracer_state(dyntracer).function_definitions;
     auto it = definitions.find(function);
     if (it != definitions.end()) {
@@ -62,9 +63,8 @@ string get_function_definition(dyntracer_t *dyntracer, const SEXP function) {
 #endif
         return it->second;
     } else {
-        string definition = get_expression(function);
-        tracer_state(dyntracer).function_definitions[function] = definition;
-        return definition;
+        return definitions.emplace(function, get_expression(function))
+            .first->second;
     }
 }
 
@@ -75,12 +75,11 @@ void remove_function_definition(dyntracer_t *dyntracer, const SEXP function) {
         tracer_state(dyntracer).function_definitions.erase(it);
 }
 
-fn_id_t get_function_id(dyntracer_t *dyntracer,
-                        const string &function_definition, bool builtin) {
-    fn_key_t definition(function_definition);
-
+const fn_id_t &get_function_id(dyntracer_t *dyntracer,
+                               const string &function_definition,
+                               bool builtin) {
     auto &function_ids = tracer_state(dyntracer).function_ids;
-    auto it = function_ids.find(definition);
+    auto it = function_ids.find(function_definition);
 
     if (it != function_ids.end()) {
         return it->second;
@@ -88,9 +87,8 @@ fn_id_t get_function_id(dyntracer_t *dyntracer,
         /*Use hash on the function body to compute a unique (hopefully) id
          for each function.*/
 
-        fn_id_t fn_id = compute_hash(definition.c_str());
-        tracer_state(dyntracer).function_ids[definition] = fn_id;
-        return fn_id;
+        fn_id_t fn_id = compute_hash(function_definition.c_str());
+        return function_ids.emplace(function_definition, fn_id).first->second;
     }
 }
 
@@ -115,6 +113,17 @@ bool function_already_inserted(dyntracer_t *dyntracer, fn_id_t id) {
 
 fn_addr_t get_function_addr(SEXP func) { return get_sexp_address(func); }
 
+location_id_t get_definition_location_id(dyntracer_t *dyntracer, SEXP op) {
+    return tracer_state(dyntracer).locations.intern(
+        getAttrib(op, R_SrcrefSymbol));
+}
+
+location_id_t get_callsite_location_id(dyntracer_t *dyntracer,
+                                       int how_far_in_the_past) {
+    return tracer_state(dyntracer).locations.intern(
+        R_GetCurrentSrcref(how_far_in_the_past));
+}
+
 call_id_t make_funcall_id(dyntracer_t *dyntracer, SEXP function) {
     if (function == R_NilValue)
         return RID_INVALID;
@@ -1,3 +1,4 @@
+#include "FunctionBodyPack.h"
 #include "table.h"
 #include "tracer.h"
 #include <R_ext/Rdynload.h>
@@ -8,10 +9,18 @@ extern "C" {
 #endif
 
 static const R_CallMethodDef CallEntries[] = {
-    {"create_dyntracer", (DL_FUNC)&create_dyntracer, 8},
+    {"create_dyntracer", (DL_FUNC)&create_dyntracer, 12},
     {"destroy_dyntracer", (DL_FUNC)&destroy_dyntracer, 1},
+    {"get_memory_usage", (DL_FUNC)&get_memory_usage, 1},
+    {"add_metadata", (DL_FUNC)&add_metadata, 2},
+    {"create_calibration_dyntracer", (DL_FUNC)&create_calibration_dyntracer,
+     1},
+    {"get_calibration_event_count", (DL_FUNC)&get_calibration_event_count, 1},
+    {"destroy_calibration_dyntracer", (DL_FUNC)&destroy_calibration_dyntracer,
+     1},
     {"write_data_table", (DL_FUNC)&write_data_table, 4},
     {"read_data_table", (DL_FUNC)&read_data_table, 3},
+    {"read_function_body", (DL_FUNC)&read_function_body, 3},
     {NULL, NULL, 0}};
 
 void attribute_visible R_init_promisedyntracer(DllInfo *dll) {
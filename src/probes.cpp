@@ -2,6 +2,75 @@
 #include "State.h"
 #include "Timer.h"
 
+/* Inside a sampled out subtree only the shadow stack is maintained, with
+   frames which carry no ids. */
+static inline bool is_sampled_out(dyntracer_t *dyntracer) {
+    return tracer_state(dyntracer).call_sampler.is_sampled_out();
+}
+
+static void push_sampled_out_frame(dyntracer_t *dyntracer, stack_type type,
+                                   function_type fn_type,
+                                   env_addr_t environment) {
+    stack_event_t stack_elem;
+    stack_elem.type = type;
+    stack_elem.call_id = RID_INVALID;
+    stack_elem.function_info.type = fn_type;
+    stack_elem.enclosing_environment = environment;
+    tracer_state(dyntracer).push_stack(stack_elem);
+}
+
+static void pop_sampled_out_frame(dyntracer_t *dyntracer) {
+    tracer_state_t &state = tracer_state(dyntracer);
+    state.pop_stack();
+    state.call_sampler.pop_to(state.full_stack.size());
+}
+
+/* Filtered calls leave no trace at all, not even a frame. */
+static inline bool is_filtered(dyntracer_t *dyntracer, const SEXP op) {
+    return tracer_state(dyntracer).call_filter.is_filtered(op);
+}
+
+static fn_id_t get_closure_function_id(dyntracer_t *dyntracer,
+                                       const SEXP op) {
+    return get_function_id(dyntracer, get_function_definition(dyntracer, op));
+}
+
+/* Calls of a degraded closure push no frame, except for those which were
+   entered before its switch-over. The environment of a closure call is
+   fresh, so it tells them apart. */
+static bool is_degraded_call(dyntracer_t *dyntracer, const SEXP op,
+                             const SEXP rho) {
+    tracer_state_t &state = tracer_state(dyntracer);
+    if (!state.call_degrader.is_degraded(op))
+        return false;
+    if (state.full_stack.empty())
+        return true;
+    const stack_event_t &frame = state.full_stack.back();
+    return frame.type != stack_type::CALL ||
+           frame.function_info.type != function_type::CLOSURE ||
+           frame.enclosing_environment != get_sexp_address(rho);
+}
+
+/* Returns false and pushes a sampled out frame if the call is not traced. */
+static bool sample_closure_call(dyntracer_t *dyntracer, const SEXP op,
+                                const SEXP rho) {
+    tracer_state_t &state = tracer_state(dyntracer);
+    CallSampler &sampler = state.call_sampler;
+
+    if (!sampler.is_sampled_out()) {
+        bool top_level = state.full_stack_counts.empty() ||
+                         state.full_stack_counts.back().closure == 0;
+        if (sampler.sample(state.full_stack.size(), top_level, [&] {
+                return get_closure_function_id(dyntracer, op);
+            }))
+            return true;
+    }
+
+    push_sampled_out_frame(dyntracer, stack_type::CALL, function_type::CLOSURE,
+                           get_sexp_address(rho));
+    return false;
+}
+
 void dyntrace_entry(dyntracer_t *dyntracer, SEXP expression, SEXP environment) {
     MAIN_TIMER_RESET();
 
@@ -24,7 +93,7 @@ void dyntrace_exit(dyntracer_t *dyntracer, SEXP expression, SEXP environment,
         dyntrace_log_warning(
             "Function/promise stack is not balanced: %d remaining",
             tracer_state(dyntracer).full_stack.size());
-        tracer_state(dyntracer).full_stack.clear();
+        tracer_state(dyntracer).clear_stack();
     }
 
     debug_serializer(dyntracer).serialize_finish_trace();
@@ -51,18 +120,29 @@ void closure_entry(dyntracer_t *dyntracer, const SEXP call, const SEXP op,
                    const SEXP args, const SEXP rho) {
     MAIN_TIMER_RESET();
 
-    closure_info_t info =
-        function_entry_get_info(dyntracer, call, op, args, rho);
+    if (tracer_state(dyntracer).call_filter.filter_entry(op))
+        return;
+
+    if (tracer_state(dyntracer).call_degrader.enter(
+            op, [&] { return get_closure_function_id(dyntracer, op); }))
+        return;
+
+    if (!sample_closure_call(dyntracer, op, rho))
+        return;
+
+    auto slot = tracer_state(dyntracer).closure_infos.acquire();
+    closure_info_t &info = slot.get();
+    function_entry_get_info(info, dyntracer, call, op, args, rho);
 
     MAIN_TIMER_END_SEGMENT(FUNCTION_ENTRY_RECORDER);
 
     stack_event_t stack_elem;
     stack_elem.type = stack_type::CALL;
     stack_elem.call_id = info.call_id;
-    stack_elem.function_info.function_id = info.fn_id;
+    stack_elem.function_info.function_id = info.interned_fn_id;
     stack_elem.function_info.type = function_type::CLOSURE;
     stack_elem.enclosing_environment = info.call_ptr;
-    tracer_state(dyntracer).full_stack.push_back(stack_elem);
+    tracer_state(dyntracer).push_stack(stack_elem);
 
     MAIN_TIMER_END_SEGMENT(FUNCTION_ENTRY_STACK);
 
@@ -80,7 +160,7 @@ void closure_entry(dyntracer_t *dyntracer, const SEXP call, const SEXP op,
     auto &fresh_promises = tracer_state(dyntracer).fresh_promises;
     bool exists = false; // dummy variable, only passed along to to_variable_id
     // Associate promises with call ID
-    for (auto argument : info.arguments) {
+    for (const auto &argument : info.arguments) {
         auto &promise = argument.promise_id;
         // if promise environment is same as the caller's environment, then
         // serialize this promise as it is a default argument.
@@ -89,7 +169,7 @@ void closure_entry(dyntracer_t *dyntracer, const SEXP call, const SEXP op,
 
         auto it = fresh_promises.find(promise);
         if (it != fresh_promises.end()) {
-            tracer_state(dyntracer).promise_origin[promise] = info.call_id;
+            tracer_state(dyntracer).promise_origin.set(promise, info.call_id);
             fresh_promises.erase(it);
         }
 
@@ -111,12 +191,22 @@ void closure_exit(dyntracer_t *dyntracer, const SEXP call, const SEXP op,
 
     MAIN_TIMER_RESET();
 
-    closure_info_t info =
-        function_exit_get_info(dyntracer, call, op, args, rho, retval);
+    if (is_filtered(dyntracer, op))
+        return;
+
+    if (is_degraded_call(dyntracer, op, rho))
+        return;
+
+    if (is_sampled_out(dyntracer))
+        return pop_sampled_out_frame(dyntracer);
+
+    auto slot = tracer_state(dyntracer).closure_infos.acquire();
+    closure_info_t &info = slot.get();
+    function_exit_get_info(info, dyntracer, call, op, args, rho, retval);
 
     MAIN_TIMER_END_SEGMENT(FUNCTION_EXIT_RECORDER);
 
-    auto thing_on_stack = tracer_state(dyntracer).full_stack.back();
+    const auto &thing_on_stack = tracer_state(dyntracer).full_stack.back();
     if (thing_on_stack.type != stack_type::CALL ||
         thing_on_stack.call_id != info.call_id) {
         dyntrace_log_warning(
@@ -125,7 +215,7 @@ void closure_exit(dyntracer_t *dyntracer, const SEXP call, const SEXP op,
             thing_on_stack.type == stack_type::PROMISE ? "promise" : "call",
             thing_on_stack.call_id, info.call_id);
     }
-    tracer_state(dyntracer).full_stack.pop_back();
+    tracer_state(dyntracer).pop_stack();
 
     MAIN_TIMER_END_SEGMENT(FUNCTION_EXIT_STACK);
 
@@ -181,8 +271,36 @@ void print_entry_info(dyntracer_t *dyntracer, const SEXP call, const SEXP op,
     MAIN_TIMER_RESET();
 
 #ifndef RDT_IGNORE_SPECIALS_AND_BUILTINS
-    builtin_info_t info =
-        builtin_entry_get_info(dyntracer, call, op, rho, fn_type);
+    if (tracer_state(dyntracer).call_filter.filter_entry(op))
+        return;
+
+    tracer_state(dyntracer).call_degrader.count_call();
+
+    if (is_sampled_out(dyntracer))
+        return push_sampled_out_frame(dyntracer, stack_type::CALL, fn_type,
+                                      get_sexp_address(rho));
+
+    tracer_state_t &state = tracer_state(dyntracer);
+    if (PrimitiveCounters::is_primitive(op)) {
+        state.primitive_counters.count(op);
+
+        /* without a consumer of the info, only the frame is needed */
+        if (state.primitive_fast_path) {
+            stack_event_t stack_elem;
+            stack_elem.type = stack_type::CALL;
+            stack_elem.call_id = make_funcall_id(dyntracer, op);
+            stack_elem.function_info.type = fn_type;
+            stack_elem.enclosing_environment = get_sexp_address(rho);
+            state.push_stack(stack_elem);
+
+            MAIN_TIMER_END_SEGMENT(BUILTIN_ENTRY_STACK);
+            return;
+        }
+    }
+
+    auto slot = tracer_state(dyntracer).builtin_infos.acquire();
+    builtin_info_t &info = slot.get();
+    builtin_entry_get_info(info, dyntracer, call, op, rho, fn_type);
 #endif
 
     MAIN_TIMER_END_SEGMENT(BUILTIN_ENTRY_RECORDER);
@@ -198,10 +316,10 @@ void print_entry_info(dyntracer_t *dyntracer, const SEXP call, const SEXP op,
     stack_event_t stack_elem;
     stack_elem.type = stack_type::CALL;
     stack_elem.call_id = info.call_id;
-    stack_elem.function_info.function_id = info.fn_id;
+    stack_elem.function_info.function_id = info.interned_fn_id;
     stack_elem.function_info.type = info.fn_type;
     stack_elem.enclosing_environment = info.call_ptr;
-    tracer_state(dyntracer).full_stack.push_back(stack_elem);
+    tracer_state(dyntracer).push_stack(stack_elem);
 #endif
 
     MAIN_TIMER_END_SEGMENT(BUILTIN_ENTRY_STACK);
@@ -228,8 +346,32 @@ void print_exit_info(dyntracer_t *dyntracer, const SEXP call, const SEXP op,
     MAIN_TIMER_RESET();
 
 #ifndef RDT_IGNORE_SPECIALS_AND_BUILTINS
-    builtin_info_t info =
-        builtin_exit_get_info(dyntracer, call, op, rho, fn_type, retval);
+    if (is_filtered(dyntracer, op))
+        return;
+
+    if (is_sampled_out(dyntracer))
+        return pop_sampled_out_frame(dyntracer);
+
+    tracer_state_t &state = tracer_state(dyntracer);
+    if (state.primitive_fast_path && PrimitiveCounters::is_primitive(op)) {
+        const stack_event_t &thing_on_stack = state.full_stack.back();
+        if (thing_on_stack.type != stack_type::CALL ||
+            thing_on_stack.function_info.type != fn_type) {
+            dyntrace_log_warning(
+                "Object on stack was %s with id %d,"
+                " but was expected to be built-in",
+                thing_on_stack.type == stack_type::PROMISE ? "promise" : "call",
+                thing_on_stack.call_id);
+        }
+        state.pop_stack();
+
+        MAIN_TIMER_END_SEGMENT(BUILTIN_EXIT_STACK);
+        return;
+    }
+
+    auto slot = tracer_state(dyntracer).builtin_infos.acquire();
+    builtin_info_t &info = slot.get();
+    builtin_exit_get_info(info, dyntracer, call, op, rho, fn_type, retval);
 #endif
 
     MAIN_TIMER_END_SEGMENT(BUILTIN_EXIT_STACK);
@@ -242,7 +384,7 @@ void print_exit_info(dyntracer_t *dyntracer, const SEXP call, const SEXP op,
     MAIN_TIMER_END_SEGMENT(BUILTIN_EXIT_ANALYSIS);
 
 #ifndef RDT_IGNORE_SPECIALS_AND_BUILTINS
-    auto thing_on_stack = tracer_state(dyntracer).full_stack.back();
+    const auto &thing_on_stack = tracer_state(dyntracer).full_stack.back();
     if (thing_on_stack.type != stack_type::CALL ||
         thing_on_stack.call_id != info.call_id) {
         dyntrace_log_warning(
@@ -251,7 +393,7 @@ void print_exit_info(dyntracer_t *dyntracer, const SEXP call, const SEXP op,
             thing_on_stack.type == stack_type::PROMISE ? "promise" : "call",
             thing_on_stack.call_id, info.call_id);
     }
-    tracer_state(dyntracer).full_stack.pop_back();
+    tracer_state(dyntracer).pop_stack();
 #endif
 
     MAIN_TIMER_END_SEGMENT(BUILTIN_EXIT_STACK);
@@ -272,6 +414,8 @@ void print_exit_info(dyntracer_t *dyntracer, const SEXP call, const SEXP op,
 }
 
 void gc_allocate(dyntracer_t *dyntracer, const SEXP object) {
+    if (is_sampled_out(dyntracer))
+        return;
     switch (TYPEOF(object)) {
         case PROMSXP:
             return promise_created(dyntracer, object);
@@ -288,7 +432,9 @@ void promise_created(dyntracer_t *dyntracer, const SEXP prom) {
 
     const SEXP rho = dyntrace_get_promise_environment(prom);
 
-    prom_basic_info_t info = create_promise_get_info(dyntracer, prom, rho);
+    auto slot = tracer_state(dyntracer).promise_basic_infos.acquire();
+    prom_basic_info_t &info = slot.get();
+    create_promise_get_info(info, dyntracer, prom, rho);
 
     MAIN_TIMER_END_SEGMENT(CREATE_PROMISE_RECORDER);
 
@@ -312,7 +458,14 @@ void promise_created(dyntracer_t *dyntracer, const SEXP prom) {
 void promise_force_entry(dyntracer_t *dyntracer, const SEXP promise) {
     MAIN_TIMER_RESET();
 
-    prom_info_t info = force_promise_entry_get_info(dyntracer, promise);
+    if (is_sampled_out(dyntracer))
+        return push_sampled_out_frame(
+            dyntracer, stack_type::PROMISE, function_type::CLOSURE,
+            tracer_state(dyntracer).full_stack.back().enclosing_environment);
+
+    auto slot = tracer_state(dyntracer).promise_infos.acquire();
+    prom_info_t &info = slot.get();
+    force_promise_entry_get_info(info, dyntracer, promise);
 
     MAIN_TIMER_END_SEGMENT(FORCE_PROMISE_ENTRY_RECORDER);
 
@@ -327,7 +480,7 @@ void promise_force_entry(dyntracer_t *dyntracer, const SEXP promise) {
         tracer_state(dyntracer)
             .full_stack.back()
             .enclosing_environment; // FIXME necessary?
-    tracer_state(dyntracer).full_stack.push_back(stack_elem);
+    tracer_state(dyntracer).push_stack(stack_elem);
 
     MAIN_TIMER_END_SEGMENT(FORCE_PROMISE_ENTRY_STACK);
 
@@ -344,7 +497,12 @@ void promise_force_entry(dyntracer_t *dyntracer, const SEXP promise) {
 void promise_force_exit(dyntracer_t *dyntracer, const SEXP promise) {
     MAIN_TIMER_RESET();
 
-    prom_info_t info = force_promise_exit_get_info(dyntracer, promise);
+    if (is_sampled_out(dyntracer))
+        return pop_sampled_out_frame(dyntracer);
+
+    auto slot = tracer_state(dyntracer).promise_infos.acquire();
+    prom_info_t &info = slot.get();
+    force_promise_exit_get_info(info, dyntracer, promise);
 
     MAIN_TIMER_END_SEGMENT(FORCE_PROMISE_EXIT_RECORDER);
 
@@ -352,7 +510,7 @@ void promise_force_exit(dyntracer_t *dyntracer, const SEXP promise) {
 
     MAIN_TIMER_END_SEGMENT(FORCE_PROMISE_EXIT_ANALYSIS);
 
-    auto thing_on_stack = tracer_state(dyntracer).full_stack.back();
+    const auto &thing_on_stack = tracer_state(dyntracer).full_stack.back();
     if (thing_on_stack.type != stack_type::PROMISE ||
         thing_on_stack.promise_id != info.prom_id) {
         dyntrace_log_warning(
@@ -361,7 +519,7 @@ void promise_force_exit(dyntracer_t *dyntracer, const SEXP promise) {
             thing_on_stack.type == stack_type::PROMISE ? "promise" : "call",
             thing_on_stack.promise_id, info.prom_id);
     }
-    tracer_state(dyntracer).full_stack.pop_back();
+    tracer_state(dyntracer).pop_stack();
 
     MAIN_TIMER_END_SEGMENT(FORCE_PROMISE_EXIT_STACK);
 
@@ -378,7 +536,12 @@ void promise_force_exit(dyntracer_t *dyntracer, const SEXP promise) {
 void promise_value_lookup(dyntracer_t *dyntracer, const SEXP promise) {
     MAIN_TIMER_RESET();
 
-    prom_info_t info = promise_lookup_get_info(dyntracer, promise);
+    if (is_sampled_out(dyntracer))
+        return;
+
+    auto slot = tracer_state(dyntracer).promise_infos.acquire();
+    prom_info_t &info = slot.get();
+    promise_lookup_get_info(info, dyntracer, promise);
 
     analysis_driver(dyntracer).promise_value_lookup(info, promise);
 
@@ -399,7 +562,13 @@ void promise_value_lookup(dyntracer_t *dyntracer, const SEXP promise) {
 
 void promise_expression_lookup(dyntracer_t *dyntracer, const SEXP prom) {
     MAIN_TIMER_RESET();
-    prom_info_t info = promise_expression_lookup_get_info(dyntracer, prom);
+
+    if (is_sampled_out(dyntracer))
+        return;
+
+    auto slot = tracer_state(dyntracer).promise_infos.acquire();
+    prom_info_t &info = slot.get();
+    promise_expression_lookup_get_info(info, dyntracer, prom);
 
     MAIN_TIMER_END_SEGMENT(LOOKUP_PROMISE_EXPRESSION_RECORDER);
 
@@ -407,9 +576,11 @@ void promise_expression_lookup(dyntracer_t *dyntracer, const SEXP prom) {
 
     MAIN_TIMER_END_SEGMENT(LOOKUP_PROMISE_EXPRESSION_ANALYSIS);
 
-    tracer_serializer(dyntracer).serialize(
-        TraceSerializer::OPCODE_PROMISE_EXPRESSION_LOOKUP, info.prom_id,
-        get_expression(dyntrace_get_promise_expression(prom)));
+    /* the deparse is only needed for the trace */
+    if (tracer_serializer(dyntracer).enable_trace())
+        tracer_serializer(dyntracer).serialize(
+            TraceSerializer::OPCODE_PROMISE_EXPRESSION_LOOKUP, info.prom_id,
+            get_expression(dyntrace_get_promise_expression(prom)));
 
     MAIN_TIMER_END_SEGMENT(LOOKUP_PROMISE_EXPRESSION_WRITE_TRACE);
 }
@@ -417,7 +588,12 @@ void promise_expression_lookup(dyntracer_t *dyntracer, const SEXP prom) {
 void promise_environment_lookup(dyntracer_t *dyntracer, const SEXP prom) {
     MAIN_TIMER_RESET();
 
-    prom_info_t info = promise_expression_lookup_get_info(dyntracer, prom);
+    if (is_sampled_out(dyntracer))
+        return;
+
+    auto slot = tracer_state(dyntracer).promise_infos.acquire();
+    prom_info_t &info = slot.get();
+    promise_expression_lookup_get_info(info, dyntracer, prom);
 
     auto environment_id{tracer_state(dyntracer).to_environment_id(
         dyntrace_get_promise_environment(prom))};
@@ -439,7 +615,12 @@ void promise_expression_assign(dyntracer_t *dyntracer, const SEXP prom,
                                const SEXP expression) {
     MAIN_TIMER_RESET();
 
-    prom_info_t info = promise_expression_lookup_get_info(dyntracer, prom);
+    if (is_sampled_out(dyntracer))
+        return;
+
+    auto slot = tracer_state(dyntracer).promise_infos.acquire();
+    prom_info_t &info = slot.get();
+    promise_expression_lookup_get_info(info, dyntracer, prom);
 
     MAIN_TIMER_END_SEGMENT(SET_PROMISE_EXPRESSION_RECORDER);
 
@@ -447,9 +628,10 @@ void promise_expression_assign(dyntracer_t *dyntracer, const SEXP prom,
 
     MAIN_TIMER_END_SEGMENT(SET_PROMISE_EXPRESSION_ANALYSIS);
 
-    tracer_serializer(dyntracer).serialize(
-        TraceSerializer::OPCODE_PROMISE_EXPRESSION_ASSIGN, info.prom_id,
-        get_expression(expression));
+    if (tracer_serializer(dyntracer).enable_trace())
+        tracer_serializer(dyntracer).serialize(
+            TraceSerializer::OPCODE_PROMISE_EXPRESSION_ASSIGN, info.prom_id,
+            get_expression(expression));
 
     MAIN_TIMER_END_SEGMENT(SET_PROMISE_EXPRESSION_WRITE_TRACE);
 }
@@ -458,7 +640,12 @@ void promise_value_assign(dyntracer_t *dyntracer, const SEXP prom,
                           const SEXP value) {
     MAIN_TIMER_RESET();
 
-    prom_info_t info = promise_expression_lookup_get_info(dyntracer, prom);
+    if (is_sampled_out(dyntracer))
+        return;
+
+    auto slot = tracer_state(dyntracer).promise_infos.acquire();
+    prom_info_t &info = slot.get();
+    promise_expression_lookup_get_info(info, dyntracer, prom);
 
     MAIN_TIMER_END_SEGMENT(SET_PROMISE_VALUE_RECORDER);
 
@@ -476,7 +663,12 @@ void promise_environment_assign(dyntracer_t *dyntracer, const SEXP prom,
 
     MAIN_TIMER_RESET();
 
-    prom_info_t info = promise_expression_lookup_get_info(dyntracer, prom);
+    if (is_sampled_out(dyntracer))
+        return;
+
+    auto slot = tracer_state(dyntracer).promise_infos.acquire();
+    prom_info_t &info = slot.get();
+    promise_expression_lookup_get_info(info, dyntracer, prom);
     auto environment_id =
         tracer_state(dyntracer).to_environment_id(environment);
 
@@ -499,6 +691,10 @@ void gc_unmark(dyntracer_t *dyntracer, const SEXP expression) {
             return gc_closure_unmark(dyntracer, expression);
         case ENVSXP:
             return gc_environment_unmark(dyntracer, expression);
+        /* srcrefs are integer vectors, or lists of them */
+        case INTSXP:
+        case VECSXP:
+            return gc_srcref_unmark(dyntracer, expression);
         default:
             return;
     }
@@ -517,12 +713,11 @@ void gc_promise_unmark(dyntracer_t *dyntracer, const SEXP promise) {
 
     MAIN_TIMER_END_SEGMENT(GC_PROMISE_UNMARKED_ANALYSIS);
 
-    auto iter = promise_origin.find(id);
-    if (iter != promise_origin.end()) {
-        // If this is one of our traced promises,
-        // delete it from origin map because it is ready to be GCed
-        promise_origin.erase(iter);
-    }
+    // If this is one of our traced promises,
+    // delete it from origin map because it is ready to be GCed
+    promise_origin.erase(id);
+    tracer_state(dyntracer).fresh_promises.erase(id);
+    tracer_state(dyntracer).promise_lookup_gc_trigger_counter.erase(id);
 
     tracer_state(dyntracer).promise_ids.erase(addr);
 
@@ -533,19 +728,37 @@ void gc_closure_unmark(dyntracer_t *dyntracer, const SEXP function) {
     MAIN_TIMER_RESET();
 
     remove_function_definition(dyntracer, function);
+    tracer_state(dyntracer).call_filter.remove(function);
+    tracer_state(dyntracer).call_degrader.remove(function);
 
     MAIN_TIMER_END_SEGMENT(GC_FUNCTION_UNMARKED_RECORD_KEEPING);
 }
 
 void gc_environment_unmark(dyntracer_t *dyntracer, const SEXP environment) {
+    MAIN_TIMER_RESET();
+
+    analysis_driver(dyntracer).gc_environment_unmarked(environment);
+
+    MAIN_TIMER_END_SEGMENT(GC_ENVIRONMENT_UNMARKED_ANALYSIS);
 
     tracer_state(dyntracer).remove_environment(environment);
+
+    MAIN_TIMER_END_SEGMENT(GC_ENVIRONMENT_UNMARKED_RECORD_KEEPING);
+}
+
+void gc_srcref_unmark(dyntracer_t *dyntracer, const SEXP srcref) {
+    LocationCache &locations = tracer_state(dyntracer).locations;
+    /* most unmarked vectors are not srcrefs, the lookup is skipped when
+       no srcref is tracked */
+    if (locations.is_enabled())
+        locations.remove(srcref);
 }
 
 void gc_entry(dyntracer_t *dyntracer, R_size_t size_needed) {
     MAIN_TIMER_RESET();
 
     tracer_state(dyntracer).increment_gc_trigger_counter();
+    clear_full_type_cache();
 
     MAIN_TIMER_END_SEGMENT(GC_ENTRY_RECORDER);
 }
@@ -555,9 +768,17 @@ void gc_exit(dyntracer_t *dyntracer, int gc_counts) {
 
     gc_info_t info{tracer_state(dyntracer).get_gc_trigger_counter()};
 
+    /* promises unmarked during this gc may have added entries for code
+       objects which have just been collected. */
+    clear_full_type_cache();
+
     MAIN_TIMER_END_SEGMENT(GC_EXIT_RECORDER);
 
     debug_serializer(dyntracer).serialize_gc_exit(info);
+
+    analysis_driver(dyntracer).gc_exit(info);
+
+    MAIN_TIMER_END_SEGMENT(GC_EXIT_ANALYSIS);
 }
 
 void vector_alloc(dyntracer_t *dyntracer, int sexptype, long length, long bytes,
@@ -584,7 +805,7 @@ void new_environment(dyntracer_t *dyntracer, const SEXP rho) {
         tracer_state(dyntracer).full_stack, stack_type::CALL);
     fn_id_t fn_id = event.type == stack_type::NONE
                         ? compute_hash("")
-                        : event.function_info.function_id;
+                        : *event.function_info.function_id;
 
     env_id_t env_id = tracer_state(dyntracer).environment_id_counter++;
 
@@ -606,7 +827,7 @@ void context_entry(dyntracer_t *dyntracer, const RCNTXT *cptr) {
     stack_event_t event;
     event.context_id = (rid_t)cptr;
     event.type = stack_type::CONTEXT;
-    tracer_state(dyntracer).full_stack.push_back(event);
+    tracer_state(dyntracer).push_stack(event);
     debug_serializer(dyntracer).serialize_begin_ctxt(cptr);
 
     MAIN_TIMER_END_SEGMENT(CONTEXT_ENTRY_STACK);
@@ -620,10 +841,16 @@ void context_jump(dyntracer_t *dyntracer, const RCNTXT *cptr,
     info.jump_context = ((rid_t)cptr);
     info.restart = restart;
 
+    bool sampled_out = is_sampled_out(dyntracer);
+
     adjust_stacks(dyntracer, info);
 
     MAIN_TIMER_END_SEGMENT(CONTEXT_JUMP_STACK);
 
+    /* a jump within a sampled out subtree unwinds no traced frame */
+    if (sampled_out && is_sampled_out(dyntracer))
+        return;
+
     analysis_driver(dyntracer).context_jump(info);
 
     MAIN_TIMER_END_SEGMENT(CONTEXT_JUMP_ANALYSIS);
@@ -636,7 +863,7 @@ void context_exit(dyntracer_t *dyntracer, const RCNTXT *cptr) {
 
     stack_event_t event = tracer_state(dyntracer).full_stack.back();
     if (event.type == stack_type::CONTEXT && ((rid_t)cptr) == event.context_id)
-        tracer_state(dyntracer).full_stack.pop_back();
+        tracer_state(dyntracer).pop_stack();
     else
         dyntrace_log_warning("Context trying to remove context %d from full "
                              "stack, but %d is on top of stack.",
@@ -647,17 +874,21 @@ void context_exit(dyntracer_t *dyntracer, const RCNTXT *cptr) {
 }
 
 void adjust_stacks(dyntracer_t *dyntracer, unwind_info_t &info) {
+    CallSampler &sampler = tracer_state(dyntracer).call_sampler;
 
     while (!tracer_state(dyntracer).full_stack.empty()) {
         stack_event_t element = (tracer_state(dyntracer).full_stack.back());
 
         // if (info.jump_target == element.enclosing_environment)
         //    break;
-        if (element.type == stack_type::CONTEXT)
-            if (info.jump_context == element.context_id)
-                break;
-            else
-                info.unwound_frames.push_back(element);
+        if (element.type == stack_type::CONTEXT &&
+            info.jump_context == element.context_id)
+            break;
+        else if (sampler.is_sampled_out(
+                     tracer_state(dyntracer).full_stack.size() - 1)) {
+            /* sampled out frames were never seen by the analyses */
+        } else if (element.type == stack_type::CONTEXT)
+            info.unwound_frames.push_back(element);
         else if (element.type == stack_type::CALL) {
             tracer_serializer(dyntracer).serialize(
                 TraceSerializer::OPCODE_FUNCTION_FINISH, element.call_id, true);
@@ -670,8 +901,10 @@ void adjust_stacks(dyntracer_t *dyntracer, unwind_info_t &info) {
         } else /* if (element.type == stack_type::NONE) */
             dyntrace_log_error("NONE object found on tracer's full stack.");
 
-        tracer_state(dyntracer).full_stack.pop_back();
+        tracer_state(dyntracer).pop_stack();
     }
+
+    sampler.pop_to(tracer_state(dyntracer).full_stack.size());
 }
 
 void environment_action(dyntracer_t *dyntracer, const SEXP symbol, SEXP value,
@@ -716,6 +949,9 @@ void environment_variable_define(dyntracer_t *dyntracer, const SEXP symbol,
                                  const SEXP value, const SEXP rho) {
     MAIN_TIMER_RESET();
 
+    if (is_sampled_out(dyntracer))
+        return;
+
     analysis_driver(dyntracer).environment_define_var(symbol, value, rho);
 
     MAIN_TIMER_END_SEGMENT(ENVIRONMENT_ACTION_ANALYSIS);
@@ -728,6 +964,9 @@ void environment_variable_assign(dyntracer_t *dyntracer, const SEXP symbol,
                                  const SEXP value, const SEXP rho) {
     MAIN_TIMER_RESET();
 
+    if (is_sampled_out(dyntracer))
+        return;
+
     analysis_driver(dyntracer).environment_assign_var(symbol, value, rho);
 
     MAIN_TIMER_END_SEGMENT(ENVIRONMENT_ACTION_ANALYSIS);
@@ -740,6 +979,9 @@ void environment_variable_remove(dyntracer_t *dyntracer, const SEXP symbol,
                                  const SEXP rho) {
     MAIN_TIMER_RESET();
 
+    if (is_sampled_out(dyntracer))
+        return;
+
     analysis_driver(dyntracer).environment_remove_var(symbol, rho);
 
     MAIN_TIMER_END_SEGMENT(ENVIRONMENT_ACTION_ANALYSIS);
@@ -752,6 +994,9 @@ void environment_variable_lookup(dyntracer_t *dyntracer, const SEXP symbol,
                                  const SEXP value, const SEXP rho) {
     MAIN_TIMER_RESET();
 
+    if (is_sampled_out(dyntracer))
+        return;
+
     analysis_driver(dyntracer).environment_lookup_var(symbol, value, rho);
 
     MAIN_TIMER_END_SEGMENT(ENVIRONMENT_ACTION_ANALYSIS);
@@ -47,6 +47,7 @@ void gc_unmark(dyntracer_t *dyntracer, const SEXP expression);
 void gc_promise_unmark(dyntracer_t *dyntracer, const SEXP promise);
 void gc_closure_unmark(dyntracer_t *dyntracer, const SEXP closure);
 void gc_environment_unmark(dyntracer_t *dyntracer, const SEXP expression);
+void gc_srcref_unmark(dyntracer_t *dyntracer, const SEXP srcref);
 void gc_entry(dyntracer_t *dyntracer, R_size_t size_needed);
 void gc_exit(dyntracer_t *dyntracer, int gc_count);
 void vector_alloc(dyntracer_t *dyntracer, int sexptype, long length, long bytes,
@@ -7,12 +7,13 @@ void update_closure_argument(closure_info_t &info, dyntracer_t *dyntracer,
                              const SEXP arg_value, const SEXP environment,
                              bool dot_argument, int position) {
 
-    arg_t argument;
+    info.arguments.emplace_back();
+    arg_t &argument = info.arguments.back();
     SEXPTYPE arg_value_type = TYPEOF(arg_value);
     SEXPTYPE arg_name_type = TYPEOF(arg_name);
 
     if (arg_name != R_NilValue) {
-        argument.name = string(get_name(arg_name));
+        argument.name = get_name(arg_name);
     } else {
         argument.name = "promise_dyntracer::missing_name";
     }
@@ -38,14 +39,14 @@ void update_closure_argument(closure_info_t &info, dyntracer_t *dyntracer,
     argument.id = get_argument_id(dyntracer, call_id, argument.name);
     argument.value_type = static_cast<sexptype_t>(arg_value_type);
     argument.formal_parameter_position = position;
-
-    info.arguments.push_back(argument);
 }
 
 void update_closure_arguments(closure_info_t &info, dyntracer_t *dyntracer,
                               const call_id_t call_id, const SEXP formals,
                               const SEXP args, const SEXP environment) {
 
+    info.arguments.clear();
+
     int formal_parameter_position = 0;
     SEXP arg_name = R_NilValue;
     SEXP arg_value = R_NilValue;
@@ -95,15 +96,27 @@ void update_closure_arguments(closure_info_t &info, dyntracer_t *dyntracer,
     info.formal_parameter_count = formal_parameter_position;
 }
 
-closure_info_t function_entry_get_info(dyntracer_t *dyntracer, const SEXP call,
-                                       const SEXP op, const SEXP args,
-                                       const SEXP rho) {
-    RECORDER_TIMER_RESET();
-    closure_info_t info;
-
+/* The name is assembled in place, to reuse its storage. */
+static void set_function_name(call_info_t &info, const SEXP call,
+                              const SEXP op) {
     const char *name = get_name(call);
     const char *ns = get_ns_name(op);
 
+    if (ns) {
+        info.name.assign(ns).append("::").append(name == NULL ? "<unknown>"
+                                                              : name);
+    } else if (name != NULL) {
+        info.name.assign(name);
+    } else {
+        info.name.clear();
+    }
+}
+
+void function_entry_get_info(closure_info_t &info, dyntracer_t *dyntracer,
+                             const SEXP call, const SEXP op, const SEXP args,
+                             const SEXP rho) {
+    RECORDER_TIMER_RESET();
+
     info.fn_compiled = is_byte_compiled(op);
     info.fn_type = function_type::CLOSURE;
     RECORDER_TIMER_END_SEGMENT(FUNCTION_ENTRY_RECORDER_OTHER);
@@ -111,7 +124,8 @@ closure_info_t function_entry_get_info(dyntracer_t *dyntracer, const SEXP call,
     info.fn_definition = get_function_definition(dyntracer, op);
     RECORDER_TIMER_END_SEGMENT(FUNCTION_ENTRY_RECORDER_DEFINITION);
 
-    info.fn_id = get_function_id(dyntracer, info.fn_definition);
+    info.interned_fn_id = &get_function_id(dyntracer, info.fn_definition);
+    info.fn_id = *info.interned_fn_id;
     RECORDER_TIMER_END_SEGMENT(FUNCTION_ENTRY_RECORDER_FUNCTION_ID);
 
     info.fn_addr = op;
@@ -121,28 +135,23 @@ closure_info_t function_entry_get_info(dyntracer_t *dyntracer, const SEXP call,
     info.call_id = make_funcall_id(dyntracer, op);
     RECORDER_TIMER_END_SEGMENT(FUNCTION_ENTRY_RECORDER_CALL_ID);
 
-    stack_event_t event = get_last_on_stack_by_type(
+    const stack_event_t &event = get_last_on_stack_by_type(
         tracer_state(dyntracer).full_stack, stack_type::CALL);
     info.parent_call_id = event.type == stack_type::NONE ? 0 : event.call_id;
     RECORDER_TIMER_END_SEGMENT(FUNCTION_ENTRY_RECORDER_PARENT_ID);
 
-    info.definition_location = get_definition_location_cpp(op);
-    info.callsite_location = get_callsite_cpp(1);
+    info.definition_location_id = get_definition_location_id(dyntracer, op);
+    info.callsite_location_id = get_callsite_location_id(dyntracer, 1);
     RECORDER_TIMER_END_SEGMENT(FUNCTION_ENTRY_RECORDER_LOCATION);
 
     void (*probe)(dyntracer_t *, SEXP);
     probe = dyntrace_active_dyntracer->probe_promise_expression_lookup;
     dyntrace_active_dyntracer->probe_promise_expression_lookup = NULL;
-    info.call_expression = get_expression(call);
+    get_expression(call, info.call_expression);
     RECORDER_TIMER_END_SEGMENT(FUNCTION_ENTRY_RECORDER_EXPRESSION);
 
     dyntrace_active_dyntracer->probe_promise_expression_lookup = probe;
-    if (ns) {
-        info.name = string(ns) + "::" + check_string(name);
-    } else {
-        if (name != NULL)
-            info.name = name;
-    }
+    set_function_name(info, call, op);
     RECORDER_TIMER_END_SEGMENT(FUNCTION_ENTRY_RECORDER_NAME);
 
     update_closure_arguments(info, dyntracer, info.call_id, FORMALS(op),
@@ -151,19 +160,14 @@ closure_info_t function_entry_get_info(dyntracer_t *dyntracer, const SEXP call,
 
     get_stack_parent(info, tracer_state(dyntracer).full_stack);
     info.in_prom_id = get_parent_promise(dyntracer);
+    info.return_value_type = static_cast<sexptype_t>(OMEGASXP);
     RECORDER_TIMER_END_SEGMENT(FUNCTION_ENTRY_RECORDER_PARENT_PROMISE);
-
-    return info;
 }
 
-closure_info_t function_exit_get_info(dyntracer_t *dyntracer, const SEXP call,
-                                      const SEXP op, const SEXP args,
-                                      const SEXP rho, const SEXP retval) {
+void function_exit_get_info(closure_info_t &info, dyntracer_t *dyntracer,
+                            const SEXP call, const SEXP op, const SEXP args,
+                            const SEXP rho, const SEXP retval) {
     RECORDER_TIMER_RESET();
-    closure_info_t info;
-
-    const char *name = get_name(call);
-    const char *ns = get_ns_name(op);
 
     info.fn_compiled = is_byte_compiled(op);
     RECORDER_TIMER_END_SEGMENT(FUNCTION_EXIT_RECORDER_OTHER);
@@ -171,12 +175,14 @@ closure_info_t function_exit_get_info(dyntracer_t *dyntracer, const SEXP call,
     info.fn_definition = get_function_definition(dyntracer, op);
     RECORDER_TIMER_END_SEGMENT(FUNCTION_EXIT_RECORDER_DEFINITION);
 
-    info.fn_id = get_function_id(dyntracer, info.fn_definition);
+    info.interned_fn_id = &get_function_id(dyntracer, info.fn_definition);
+    info.fn_id = *info.interned_fn_id;
     RECORDER_TIMER_END_SEGMENT(FUNCTION_EXIT_RECORDER_FUNCTION_ID);
 
     info.fn_addr = op;
+    info.call_ptr = get_sexp_address(rho);
 
-    stack_event_t call_event = get_last_on_stack_by_type(
+    const stack_event_t &call_event = get_last_on_stack_by_type(
         tracer_state(dyntracer).full_stack, stack_type::CALL);
     info.call_id = call_event.type == stack_type::NONE ? 0 : call_event.call_id;
     RECORDER_TIMER_END_SEGMENT(FUNCTION_EXIT_RECORDER_CALL_ID);
@@ -184,25 +190,19 @@ closure_info_t function_exit_get_info(dyntracer_t *dyntracer, const SEXP call,
     info.fn_type = function_type::CLOSURE;
     RECORDER_TIMER_END_SEGMENT(FUNCTION_EXIT_RECORDER_OTHER);
 
-    info.definition_location = get_definition_location_cpp(op);
-    info.callsite_location = get_callsite_cpp(0);
+    info.definition_location_id = get_definition_location_id(dyntracer, op);
+    info.callsite_location_id = get_callsite_location_id(dyntracer, 0);
     RECORDER_TIMER_END_SEGMENT(FUNCTION_EXIT_RECORDER_LOCATION);
 
-    if (ns) {
-        info.name = string(ns) + "::" + check_string(name);
-    } else {
-        if (name != NULL)
-            info.name = name;
-    }
+    set_function_name(info, call, op);
+    info.call_expression.clear();
     RECORDER_TIMER_END_SEGMENT(FUNCTION_EXIT_RECORDER_NAME);
 
     update_closure_arguments(info, dyntracer, info.call_id, FORMALS(op),
                              FRAME(rho), rho);
     RECORDER_TIMER_END_SEGMENT(FUNCTION_EXIT_RECORDER_ARGUMENTS);
 
-    info.fn_definition = get_expression(op);
-
-    stack_event_t parent_call = get_from_back_of_stack_by_type(
+    const stack_event_t &parent_call = get_from_back_of_stack_by_type(
         tracer_state(dyntracer).full_stack, stack_type::CALL, 1);
     info.parent_call_id =
         parent_call.type == stack_type::NONE ? 0 : parent_call.call_id;
@@ -214,61 +214,62 @@ closure_info_t function_exit_get_info(dyntracer_t *dyntracer, const SEXP call,
 
     info.return_value_type = static_cast<sexptype_t>(TYPEOF(retval));
     RECORDER_TIMER_END_SEGMENT(FUNCTION_EXIT_RECORDER_OTHER);
-
-    return info;
 }
 
-builtin_info_t builtin_entry_get_info(dyntracer_t *dyntracer, const SEXP call,
-                                      const SEXP op, const SEXP rho,
-                                      function_type fn_type) {
-    builtin_info_t info;
+void builtin_entry_get_info(builtin_info_t &info, dyntracer_t *dyntracer,
+                            const SEXP call, const SEXP op, const SEXP rho,
+                            function_type fn_type) {
     const char *name = get_name(call);
     if (name != NULL)
-        info.name = name;
+        info.name.assign(name);
+    else
+        info.name.clear();
     info.fn_definition = get_function_definition(dyntracer, op);
-    info.fn_id = get_function_id(dyntracer, info.fn_definition, true);
+    info.interned_fn_id =
+        &get_function_id(dyntracer, info.fn_definition, true);
+    info.fn_id = *info.interned_fn_id;
     info.fn_addr = op;
-    info.name = info.name;
     info.fn_type = fn_type;
     info.fn_compiled = is_byte_compiled(op);
-    stack_event_t elem = get_last_on_stack_by_type(
+    const stack_event_t &elem = get_last_on_stack_by_type(
         tracer_state(dyntracer).full_stack, stack_type::CALL);
     info.parent_call_id = elem.type == stack_type::NONE ? 0 : elem.call_id;
-    info.definition_location = get_definition_location_cpp(op);
-    info.callsite_location = get_callsite_cpp(0);
+    info.definition_location_id = get_definition_location_id(dyntracer, op);
+    info.callsite_location_id = get_callsite_location_id(dyntracer, 0);
     info.call_ptr = get_sexp_address(rho);
     info.call_id = make_funcall_id(dyntracer, op);
 
     get_stack_parent(info, tracer_state(dyntracer).full_stack);
     info.in_prom_id = get_parent_promise(dyntracer);
     info.formal_parameter_count = PRIMARITY(op);
-
-    return info;
+    info.return_value_type = static_cast<sexptype_t>(OMEGASXP);
+    info.call_expression.clear();
 }
 
-builtin_info_t builtin_exit_get_info(dyntracer_t *dyntracer, const SEXP call,
-                                     const SEXP op, const SEXP rho,
-                                     function_type fn_type, const SEXP retval) {
-    builtin_info_t info;
-
+void builtin_exit_get_info(builtin_info_t &info, dyntracer_t *dyntracer,
+                           const SEXP call, const SEXP op, const SEXP rho,
+                           function_type fn_type, const SEXP retval) {
     const char *name = get_name(call);
     if (name != NULL)
-        info.name = name;
+        info.name.assign(name);
+    else
+        info.name.clear();
     info.fn_definition = get_function_definition(dyntracer, op);
-    info.fn_id = get_function_id(dyntracer, info.fn_definition, true);
+    info.interned_fn_id =
+        &get_function_id(dyntracer, info.fn_definition, true);
+    info.fn_id = *info.interned_fn_id;
     info.fn_addr = op;
-    stack_event_t elem = get_last_on_stack_by_type(
+    info.call_ptr = get_sexp_address(rho);
+    const stack_event_t &elem = get_last_on_stack_by_type(
         tracer_state(dyntracer).full_stack, stack_type::CALL);
 
     info.call_id = elem.type == stack_type::NONE ? 0 : elem.call_id;
-    if (name != NULL)
-        info.name = name;
     info.fn_type = fn_type;
     info.fn_compiled = is_byte_compiled(op);
-    info.definition_location = get_definition_location_cpp(op);
-    info.callsite_location = get_callsite_cpp(0);
+    info.definition_location_id = get_definition_location_id(dyntracer, op);
+    info.callsite_location_id = get_callsite_location_id(dyntracer, 0);
 
-    stack_event_t parent_call = get_from_back_of_stack_by_type(
+    const stack_event_t &parent_call = get_from_back_of_stack_by_type(
         tracer_state(dyntracer).full_stack, stack_type::CALL, 1);
     info.parent_call_id =
         parent_call.type == stack_type::NONE ? 0 : parent_call.call_id;
@@ -277,19 +278,21 @@ builtin_info_t builtin_exit_get_info(dyntracer_t *dyntracer, const SEXP call,
     info.in_prom_id = get_parent_promise(dyntracer);
     info.return_value_type = static_cast<sexptype_t>(TYPEOF(retval));
     info.formal_parameter_count = PRIMARITY(op);
-
-    return info;
+    info.call_expression.clear();
 }
 
-prom_basic_info_t create_promise_get_info(dyntracer_t *dyntracer,
-                                          const SEXP promise, const SEXP rho) {
-    prom_basic_info_t info;
-
+void create_promise_get_info(prom_basic_info_t &info, dyntracer_t *dyntracer,
+                             const SEXP promise, const SEXP rho) {
     info.prom_id = make_promise_id(dyntracer, promise);
+    info.promise_environment = PRENV(promise);
     tracer_state(dyntracer).fresh_promises.insert(info.prom_id);
 
     info.prom_type = static_cast<sexptype_t>(TYPEOF(PRCODE(promise)));
-    get_full_type(promise, info.full_type);
+    /* the full type is only reported in the debug output and the event
+       log */
+    info.full_type.clear();
+    if (tracer_state(dyntracer).full_promise_type)
+        get_full_type(promise, info.full_type);
 
     get_stack_parent(info, tracer_state(dyntracer).full_stack);
     info.in_prom_id = get_parent_promise(dyntracer);
@@ -297,24 +300,28 @@ prom_basic_info_t create_promise_get_info(dyntracer_t *dyntracer,
     void (*probe)(dyntracer_t *, SEXP);
     // probe = dyntrace_active_dyntracer->probe_promise_expression_lookup;
     // dyntrace_active_dyntracer->probe_promise_expression_lookup = NULL;
-    info.expression =
-        "not computed for efficiency"; // get_expression(PRCODE(promise));
+    info.expression.assign(
+        "not computed for efficiency"); // get_expression(PRCODE(promise));
     // dyntrace_active_dyntracer->probe_promise_expression_lookup = probe;
-    return info;
 }
 
-prom_info_t force_promise_entry_get_info(dyntracer_t *dyntracer,
-                                         const SEXP promise) {
-    prom_info_t info;
+void force_promise_entry_get_info(prom_info_t &info, dyntracer_t *dyntracer,
+                                  const SEXP promise) {
     info.prom_id = get_promise_id(dyntracer, promise);
+    info.promise_environment = PRENV(promise);
 
-    stack_event_t elem = get_last_on_stack_by_type(
+    const stack_event_t &elem = get_last_on_stack_by_type(
         tracer_state(dyntracer).full_stack, stack_type::CALL);
     info.in_call_id = elem.type == stack_type::NONE ? 0 : elem.call_id;
-    info.from_call_id = tracer_state(dyntracer).promise_origin[info.prom_id];
+    info.from_call_id =
+        tracer_state(dyntracer).promise_origin.get(info.prom_id);
 
     info.prom_type = static_cast<sexptype_t>(TYPEOF(PRCODE(promise)));
-    get_full_type(promise, info.full_type);
+    /* the full type is only reported in the debug output and the event
+       log */
+    info.full_type.clear();
+    if (tracer_state(dyntracer).full_promise_type)
+        get_full_type(promise, info.full_type);
     info.return_type = (sexptype_t)OMEGASXP;
     get_stack_parent(info, tracer_state(dyntracer).full_stack);
     info.in_prom_id = get_parent_promise(dyntracer);
@@ -322,68 +329,73 @@ prom_info_t force_promise_entry_get_info(dyntracer_t *dyntracer,
     void (*probe)(dyntracer_t *, SEXP);
     // probe = dyntrace_active_dyntracer->probe_promise_expression_lookup;
     // dyntrace_active_dyntracer->probe_promise_expression_lookup = NULL;
-    info.expression = "not computed for efficiency";
-    get_expression(PRCODE(promise));
+    info.expression.assign("not computed for efficiency");
     // dyntrace_active_dyntracer->probe_promise_expression_lookup = probe;
-    return info;
 }
 
-prom_info_t force_promise_exit_get_info(dyntracer_t *dyntracer,
-                                        const SEXP promise) {
-    prom_info_t info;
+void force_promise_exit_get_info(prom_info_t &info, dyntracer_t *dyntracer,
+                                 const SEXP promise) {
     info.prom_id = get_promise_id(dyntracer, promise);
+    info.promise_environment = PRENV(promise);
 
-    stack_event_t elem = get_last_on_stack_by_type(
+    const stack_event_t &elem = get_last_on_stack_by_type(
         tracer_state(dyntracer).full_stack, stack_type::CALL);
     info.in_call_id = elem.type == stack_type::NONE ? 0 : elem.call_id;
-    info.from_call_id = tracer_state(dyntracer).promise_origin[info.prom_id];
+    info.from_call_id =
+        tracer_state(dyntracer).promise_origin.get(info.prom_id);
 
     info.prom_type = static_cast<sexptype_t>(TYPEOF(PRCODE(promise)));
-    get_full_type(promise, info.full_type);
+    /* the full type is only reported in the debug output and the event
+       log */
+    info.full_type.clear();
+    if (tracer_state(dyntracer).full_promise_type)
+        get_full_type(promise, info.full_type);
     info.return_type = static_cast<sexptype_t>(TYPEOF(PRVALUE(promise)));
 
     get_stack_parent2(info, tracer_state(dyntracer).full_stack);
     info.in_prom_id = get_parent_promise(dyntracer);
     info.depth = get_no_of_ancestor_promises_on_stack(dyntracer);
-
-    return info;
+    info.expression.clear();
 }
 
-prom_info_t promise_lookup_get_info(dyntracer_t *dyntracer,
-                                    const SEXP promise) {
-    prom_info_t info;
+void promise_lookup_get_info(prom_info_t &info, dyntracer_t *dyntracer,
+                             const SEXP promise) {
     info.prom_id = get_promise_id(dyntracer, promise);
+    info.promise_environment = PRENV(promise);
 
-    stack_event_t elem = get_last_on_stack_by_type(
+    const stack_event_t &elem = get_last_on_stack_by_type(
         tracer_state(dyntracer).full_stack, stack_type::CALL);
     info.in_call_id = elem.type == stack_type::NONE ? 0 : elem.call_id;
-    info.from_call_id = tracer_state(dyntracer).promise_origin[info.prom_id];
+    info.from_call_id =
+        tracer_state(dyntracer).promise_origin.get(info.prom_id);
 
     info.prom_type = static_cast<sexptype_t>(TYPEOF(PRCODE(promise)));
-    info.full_type.push_back((sexptype_t)OMEGASXP);
+    info.full_type.assign(1, (sexptype_t)OMEGASXP);
     info.return_type = static_cast<sexptype_t>(TYPEOF(PRVALUE(promise)));
 
     get_stack_parent(info, tracer_state(dyntracer).full_stack);
     info.in_prom_id = get_parent_promise(dyntracer);
     info.depth = get_no_of_ancestor_promises_on_stack(dyntracer);
-
-    return info;
+    info.expression.clear();
 }
 
-prom_info_t promise_expression_lookup_get_info(dyntracer_t *dyntracer,
-                                               const SEXP prom) {
-    prom_info_t info;
-
+void promise_expression_lookup_get_info(prom_info_t &info,
+                                        dyntracer_t *dyntracer,
+                                        const SEXP prom) {
     info.prom_id = get_promise_id(dyntracer, prom);
+    info.promise_environment = PRENV(prom);
 
-    stack_event_t elem = get_last_on_stack_by_type(
+    const stack_event_t &elem = get_last_on_stack_by_type(
         tracer_state(dyntracer).full_stack, stack_type::CALL);
     info.in_call_id = elem.type == stack_type::NONE ? 0 : elem.call_id;
-    info.from_call_id = tracer_state(dyntracer).promise_origin[info.prom_id];
+    info.from_call_id =
+        tracer_state(dyntracer).promise_origin.get(info.prom_id);
 
     info.prom_type = static_cast<sexptype_t>(TYPEOF(PRCODE(prom)));
-    info.full_type.push_back((sexptype_t)OMEGASXP);
+    info.full_type.assign(1, (sexptype_t)OMEGASXP);
     info.return_type = static_cast<sexptype_t>(TYPEOF(PRCODE(prom)));
-
-    return info;
+    info.parent_on_stack.type = stack_type::NONE;
+    info.in_prom_id = 0;
+    info.depth = 0;
+    info.expression.clear();
 }
@@ -6,27 +6,31 @@
 #include "sexptypes.h"
 #include "utilities.h"
 
-closure_info_t function_entry_get_info(dyntracer_t *dyntracer, const SEXP call,
-                                       const SEXP op, const SEXP args,
-                                       const SEXP rho);
-closure_info_t function_exit_get_info(dyntracer_t *dyntracer, const SEXP call,
-                                      const SEXP op, const SEXP args,
-                                      const SEXP rho, const SEXP retval);
-builtin_info_t builtin_entry_get_info(dyntracer_t *dyntracer, const SEXP call,
-                                      const SEXP op, const SEXP rho,
-                                      function_type fn_type);
-builtin_info_t builtin_exit_get_info(dyntracer_t *dyntracer, const SEXP call,
-                                     const SEXP op, const SEXP rho,
-                                     function_type fn_type, const SEXP retval);
-prom_basic_info_t create_promise_get_info(dyntracer_t *dyntracer,
-                                          const SEXP promise, const SEXP rho);
-prom_info_t force_promise_entry_get_info(dyntracer_t *dyntracer,
-                                         const SEXP promise);
-prom_info_t force_promise_exit_get_info(dyntracer_t *dyntracer,
-                                        const SEXP promise);
-prom_info_t promise_lookup_get_info(dyntracer_t *dyntracer, const SEXP promise);
-prom_info_t promise_expression_lookup_get_info(dyntracer_t *dyntracer,
-                                               const SEXP prom);
+/* The recorder fills the info structs in place, every field is overwritten,
+   so that the structs can be reused across probes. */
+void function_entry_get_info(closure_info_t &info, dyntracer_t *dyntracer,
+                             const SEXP call, const SEXP op, const SEXP args,
+                             const SEXP rho);
+void function_exit_get_info(closure_info_t &info, dyntracer_t *dyntracer,
+                            const SEXP call, const SEXP op, const SEXP args,
+                            const SEXP rho, const SEXP retval);
+void builtin_entry_get_info(builtin_info_t &info, dyntracer_t *dyntracer,
+                            const SEXP call, const SEXP op, const SEXP rho,
+                            function_type fn_type);
+void builtin_exit_get_info(builtin_info_t &info, dyntracer_t *dyntracer,
+                           const SEXP call, const SEXP op, const SEXP rho,
+                           function_type fn_type, const SEXP retval);
+void create_promise_get_info(prom_basic_info_t &info, dyntracer_t *dyntracer,
+                             const SEXP promise, const SEXP rho);
+void force_promise_entry_get_info(prom_info_t &info, dyntracer_t *dyntracer,
+                                  const SEXP promise);
+void force_promise_exit_get_info(prom_info_t &info, dyntracer_t *dyntracer,
+                                 const SEXP promise);
+void promise_lookup_get_info(prom_info_t &info, dyntracer_t *dyntracer,
+                             const SEXP promise);
+void promise_expression_lookup_get_info(prom_info_t &info,
+                                        dyntracer_t *dyntracer,
+                                        const SEXP prom);
 gc_info_t gc_exit_get_info(int gc_count);
 
 // When doing longjump (exception thrown, etc.) this function gets the
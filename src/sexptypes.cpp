@@ -1,9 +1,12 @@
 #include "sexptypes.h"
 #include "lookup.h"
+#include <algorithm>
+#include <array>
 
 const sexptype_t OMEGASXP = 100000;
 const sexptype_t ACTIVESXP = 100001;
 const sexptype_t UNBOUNDSXP = 100002;
+const sexptype_t JUMPSXP = 100003;
 
 std::string sexptype_to_string(sexptype_t sexptype) {
     switch (sexptype) {
@@ -23,6 +26,8 @@ std::string sexptype_to_string(sexptype_t sexptype) {
             return "Omega";
         case ACTIVESXP:
             return "Active binding";
+        case JUMPSXP:
+            return "Unknown (Jumped)";
         default:
             std::string str(type2char(sexptype));
             str[0] = std::toupper(str[0]);
@@ -37,11 +42,44 @@ std::string value_type_to_string(SEXP value) {
     return sexptype_to_string(static_cast<sexptype_t>(TYPEOF(value)));
 }
 
+/* Promises visited while following a chain of promises. Chains are short,
+   so a linear scan over a small array is cheaper than a tree. A chain longer
+   than the capacity is cut off as if it were cyclic. */
+class visited_promises_t {
+  public:
+    visited_promises_t() : size_{0} {}
+
+    bool contains(SEXP promise) const {
+        return std::find(promises_.begin(), promises_.begin() + size_,
+                         promise) != promises_.begin() + size_;
+    }
+
+    bool insert(SEXP promise) {
+        if (size_ == CAPACITY)
+            return false;
+        promises_[size_++] = promise;
+        return true;
+    }
+
+  private:
+    static constexpr std::size_t CAPACITY = 32;
+    std::array<SEXP, CAPACITY> promises_;
+    std::size_t size_;
+};
+
+/* Types inferred for bytecode objects whose inference did not look up any
+   symbol or follow any promise, and hence does not depend on the
+   environment. Addresses are reused after the objects are collected, so
+   the cache is cleared on entry to and exit from every gc. */
+static std::unordered_map<SEXP, full_sexp_type> full_type_cache;
+
 void get_full_type_inner(SEXP sexp, SEXP rho, full_sexp_type &result,
-                         std::set<SEXP> &visited);
+                         visited_promises_t &visited,
+                         bool &environment_dependent);
 
 void infer_type_from_bytecode(SEXP bc, SEXP rho, full_sexp_type &result,
-                              std::set<SEXP> &visited) {
+                              visited_promises_t &visited,
+                              bool &environment_dependent) {
 
     // retrieve the instructions
     SEXP code = BCODE_CODE(bc);
@@ -67,21 +105,24 @@ void infer_type_from_bytecode(SEXP bc, SEXP rho, full_sexp_type &result,
         int index = pc[2].i;
         SEXP consts = BCODE_CONSTS(bc);
         SEXP value = VECTOR_ELT(consts, index);
-        get_full_type_inner(value, rho, result, visited);
+        get_full_type_inner(value, rho, result, visited,
+                            environment_dependent);
     }
     /* lookup value bound to symbol in the environment */
     else if (opcode == GETVAR_OP || opcode == DDVAL_OP) {
         int index = pc[2].i;
         SEXP consts = BCODE_CONSTS(bc);
         SEXP value = VECTOR_ELT(consts, index);
-        get_full_type_inner(value, rho, result, visited);
+        get_full_type_inner(value, rho, result, visited,
+                            environment_dependent);
     }
     /* guard for inlined expression (function call) */
     else if (opcode == BASEGUARD_OP) {
         int index = pc[2].i;
         SEXP consts = BCODE_CONSTS(bc);
         SEXP value = VECTOR_ELT(consts, index);
-        get_full_type_inner(value, rho, result, visited);
+        get_full_type_inner(value, rho, result, visited,
+                            environment_dependent);
     }
     /* looping function calls - while, repeat, etc. */
     else if (opcode == STARTLOOPCNTXT_OP)
@@ -109,28 +150,30 @@ void infer_type_from_bytecode(SEXP bc, SEXP rho, full_sexp_type &result,
 }
 
 void get_full_type_inner(SEXP sexp, SEXP rho, full_sexp_type &result,
-                         std::set<SEXP> &visited) {
+                         visited_promises_t &visited,
+                         bool &environment_dependent) {
     sexptype_t type = static_cast<sexptype_t>(TYPEOF(sexp));
     result.push_back(type);
 
-    if (type == PROMSXP && visited.find(sexp) != visited.end()) {
-        result.push_back((sexptype_t)OMEGASXP);
-        return;
-    } else {
-        visited.insert(sexp);
-    }
-
     if (type == (sexptype_t)PROMSXP) {
-        get_full_type_inner(PRCODE(sexp), PRENV(sexp), result, visited);
+        environment_dependent = true;
+        if (visited.contains(sexp) || !visited.insert(sexp)) {
+            result.push_back((sexptype_t)OMEGASXP);
+            return;
+        }
+        get_full_type_inner(PRCODE(sexp), PRENV(sexp), result, visited,
+                            environment_dependent);
         return;
     }
 
     if (type == (sexptype_t)BCODESXP) {
-        infer_type_from_bytecode(sexp, rho, result, visited);
+        infer_type_from_bytecode(sexp, rho, result, visited,
+                                 environment_dependent);
         return;
     }
 
     if (type == (sexptype_t)SYMSXP) {
+        environment_dependent = true;
         lookup_result r = find_binding_in_environment(sexp, rho);
 
         switch (r.status) {
@@ -143,7 +186,8 @@ void get_full_type_inner(SEXP sexp, SEXP rho, full_sexp_type &result,
                     return;
                 }
 
-                get_full_type_inner(r.value, r.environment, result, visited);
+                get_full_type_inner(r.value, r.environment, result, visited,
+                                    environment_dependent);
 
                 return;
             }
@@ -178,10 +222,33 @@ void get_full_type_inner(SEXP sexp, SEXP rho, full_sexp_type &result,
 }
 
 void get_full_type(SEXP promise, full_sexp_type &result) {
-    std::set<SEXP> visited;
-    get_full_type_inner(PRCODE(promise), PRENV(promise), result, visited);
+    SEXP code = PRCODE(promise);
+    visited_promises_t visited;
+    bool environment_dependent = false;
+
+    if (TYPEOF(code) != BCODESXP) {
+        get_full_type_inner(code, PRENV(promise), result, visited,
+                            environment_dependent);
+        return;
+    }
+
+    auto iter = full_type_cache.find(code);
+    if (iter != full_type_cache.end()) {
+        result.insert(result.end(), iter->second.begin(), iter->second.end());
+        return;
+    }
+
+    std::size_t start = result.size();
+    get_full_type_inner(code, PRENV(promise), result, visited,
+                        environment_dependent);
+    if (!environment_dependent) {
+        full_type_cache.emplace(
+            code, full_sexp_type(result.begin() + start, result.end()));
+    }
 }
 
+void clear_full_type_cache() { full_type_cache.clear(); }
+
 std::string full_sexp_type_to_string(full_sexp_type type) {
     std::stringstream result;
     bool first = true;
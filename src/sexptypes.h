@@ -141,10 +141,12 @@ typedef unsigned int sexptype_t;
 extern const sexptype_t OMEGASXP;
 extern const sexptype_t ACTIVESXP;
 extern const sexptype_t UNBOUNDSXP;
+extern const sexptype_t JUMPSXP;
 
 typedef std::vector<sexptype_t> full_sexp_type;
 
 void get_full_type(SEXP promise, full_sexp_type &result);
+void clear_full_type_cache();
 std::string full_sexp_type_to_string(full_sexp_type);
 std::string full_sexp_type_to_number_string(full_sexp_type);
 std::string sexptype_to_string(sexptype_t);
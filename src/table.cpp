@@ -3,24 +3,6 @@
 #include "TextDataTableStream.h"
 #include "utilities.h"
 
-DataTableStream *create_data_table(const std::string &table_filepath,
-                                   const std::vector<std::string> &column_names,
-                                   bool truncate, bool binary,
-                                   int compression_level) {
-    std::string extension = compression_level == 0 ? "" : ".zst";
-    DataTableStream *stream = nullptr;
-    if (binary) {
-        stream = new BinaryDataTableStream(table_filepath + ".bin" + extension,
-                                           column_names, truncate,
-                                           compression_level);
-    } else {
-        stream =
-            new TextDataTableStream(table_filepath + ".csv" + extension,
-                                    column_names, truncate, compression_level);
-    }
-    return stream;
-}
-
 SEXP write_data_table(SEXP data_frame, SEXP table_filepath, SEXP truncate,
                       SEXP binary, SEXP compression_level) {
 
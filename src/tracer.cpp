@@ -1,6 +1,17 @@
 #include "tracer.h"
 #include "probes.h"
 
+#include <cstring>
+
+/* Calibration tracers attach probes which only count the events they
+   receive. Running the same workload with no probes and with one probe
+   family at a time gives the cost of the dyntrace callback mechanism,
+   separately from the work done by the probes of this package. */
+template <typename... Args>
+static void count_event(dyntracer_t *dyntracer, Args... args) {
+    ++*static_cast<std::uint64_t *>(dyntracer->state);
+}
+
 extern "C" {
 
 // verbose:
@@ -10,12 +21,31 @@ extern "C" {
 //     -1: SQL queries,
 SEXP create_dyntracer(SEXP trace_filepath, SEXP truncate, SEXP enable_trace,
                       SEXP verbose, SEXP output_dir, SEXP binary,
-                      SEXP compression_level, SEXP analysis_switch) {
-    void *context = new Context(
+                      SEXP compression_level, SEXP analysis_switch,
+                      SEXP allowed_namespaces, SEXP denied_namespaces,
+                      SEXP allowed_functions, SEXP denied_functions) {
+    /* invalid options are reported with Rf_error, which long jumps, so
+       they are parsed before any C++ object is alive */
+    const AnalysisSwitch options = to_analysis_switch(analysis_switch);
+
+    Context *context = new Context(
         sexp_to_string(trace_filepath), sexp_to_bool(truncate),
         sexp_to_bool(enable_trace), sexp_to_bool(verbose),
         sexp_to_string(output_dir), sexp_to_bool(binary),
-        sexp_to_int(compression_level), to_analysis_switch(analysis_switch));
+        sexp_to_int(compression_level), options);
+
+    /* the namespaces are character vectors and the functions are lists of
+       function objects, resolved on the R side */
+    CallFilter &call_filter = context->get_state().call_filter;
+    for (int index = 0; index < Rf_length(allowed_namespaces); ++index)
+        call_filter.allow_namespace(
+            CHAR(STRING_ELT(allowed_namespaces, index)));
+    for (int index = 0; index < Rf_length(denied_namespaces); ++index)
+        call_filter.deny_namespace(CHAR(STRING_ELT(denied_namespaces, index)));
+    for (int index = 0; index < Rf_length(allowed_functions); ++index)
+        call_filter.allow_function(VECTOR_ELT(allowed_functions, index));
+    for (int index = 0; index < Rf_length(denied_functions); ++index)
+        call_filter.deny_function(VECTOR_ELT(denied_functions, index));
 
     /* calloc initializes the memory to zero. This ensures that probes not
        attached will be NULL. Replacing calloc with malloc will cause
@@ -66,4 +96,128 @@ SEXP destroy_dyntracer(SEXP dyntracer_sexp) {
     return dyntracer_destroy_sexp(dyntracer_sexp, destroy_promise_dyntracer);
 }
 
+/* list of the entry count and the approximate size in bytes of every
+   component of the tracer state and of the enabled analyses */
+SEXP get_memory_usage(SEXP dyntracer_sexp) {
+    dyntracer_t *dyntracer = dyntracer_from_sexp(dyntracer_sexp);
+    MemoryAccount account;
+    analysis_driver(dyntracer).account_memory(account);
+
+    const auto &usages = account.get_usages();
+    int count = usages.size();
+
+    SEXP components = PROTECT(allocVector(STRSXP, count));
+    SEXP entries = PROTECT(allocVector(REALSXP, count));
+    SEXP bytes = PROTECT(allocVector(REALSXP, count));
+
+    for (int index = 0; index < count; ++index) {
+        SET_STRING_ELT(components, index,
+                       mkChar(usages[index].component.c_str()));
+        REAL(entries)[index] = usages[index].entries;
+        REAL(bytes)[index] = usages[index].bytes;
+    }
+
+    SEXP usage = PROTECT(allocVector(VECSXP, 3));
+    SET_VECTOR_ELT(usage, 0, components);
+    SET_VECTOR_ELT(usage, 1, entries);
+    SET_VECTOR_ELT(usage, 2, bytes);
+
+    SEXP names = PROTECT(allocVector(STRSXP, 3));
+    SET_STRING_ELT(names, 0, mkChar("component"));
+    SET_STRING_ELT(names, 1, mkChar("entries"));
+    SET_STRING_ELT(names, 2, mkChar("bytes"));
+    setAttrib(usage, R_NamesSymbol, names);
+
+    UNPROTECT(5);
+    return usage;
+}
+
+/* adds the elements of a named numeric vector to the metadata output */
+SEXP add_metadata(SEXP dyntracer_sexp, SEXP metadata) {
+    dyntracer_t *dyntracer = dyntracer_from_sexp(dyntracer_sexp);
+    SEXP names = getAttrib(metadata, R_NamesSymbol);
+    for (int index = 0; index < LENGTH(metadata); ++index) {
+        analysis_driver(dyntracer).add_metadata(
+            CHAR(STRING_ELT(names, index)),
+            std::to_string(REAL(metadata)[index]));
+    }
+    return R_NilValue;
+}
+
+/* "all" counts the events of every probe family, which is the number of
+   events a tracer with all probes receives */
+SEXP create_calibration_dyntracer(SEXP probe_family) {
+    /* checked before any C++ object is alive, Rf_error does not return */
+    const char *family_name = CHAR(STRING_ELT(probe_family, 0));
+    if (std::strcmp(family_name, "all") != 0 &&
+        std::strcmp(family_name, "none") != 0 &&
+        std::strcmp(family_name, "function") != 0 &&
+        std::strcmp(family_name, "promise") != 0 &&
+        std::strcmp(family_name, "gc") != 0 &&
+        std::strcmp(family_name, "context") != 0 &&
+        std::strcmp(family_name, "environment") != 0) {
+        Rf_error("unknown probe family %s", family_name);
+    }
+
+    const std::string family = family_name;
+    const bool all = family == "all";
+
+    dyntracer_t *dyntracer = (dyntracer_t *)calloc(1, sizeof(dyntracer_t));
+    dyntracer->state = new std::uint64_t(0);
+
+    if (all || family == "function") {
+        dyntracer->probe_closure_entry = count_event;
+        dyntracer->probe_closure_exit = count_event;
+        dyntracer->probe_builtin_entry = count_event;
+        dyntracer->probe_builtin_exit = count_event;
+        dyntracer->probe_special_entry = count_event;
+        dyntracer->probe_special_exit = count_event;
+    }
+    if (all || family == "promise") {
+        dyntracer->probe_promise_force_entry = count_event;
+        dyntracer->probe_promise_force_exit = count_event;
+        dyntracer->probe_promise_value_lookup = count_event;
+        dyntracer->probe_promise_expression_lookup = count_event;
+        dyntracer->probe_promise_environment_lookup = count_event;
+        dyntracer->probe_promise_value_assign = count_event;
+        dyntracer->probe_promise_expression_assign = count_event;
+        dyntracer->probe_promise_environment_assign = count_event;
+    }
+    if (all || family == "gc") {
+        dyntracer->probe_gc_unmark = count_event;
+        dyntracer->probe_gc_allocate = count_event;
+        dyntracer->probe_gc_entry = count_event;
+        dyntracer->probe_gc_exit = count_event;
+    }
+    if (all || family == "context") {
+        dyntracer->probe_context_entry = count_event;
+        dyntracer->probe_context_jump = count_event;
+        dyntracer->probe_context_exit = count_event;
+    }
+    if (all || family == "environment") {
+        dyntracer->probe_environment_variable_define = count_event;
+        dyntracer->probe_environment_variable_assign = count_event;
+        dyntracer->probe_environment_variable_remove = count_event;
+        dyntracer->probe_environment_variable_lookup = count_event;
+    }
+
+    return dyntracer_to_sexp(dyntracer, "dyntracer.calibration");
+}
+
+SEXP get_calibration_event_count(SEXP dyntracer_sexp) {
+    dyntracer_t *dyntracer = dyntracer_from_sexp(dyntracer_sexp);
+    return ScalarReal(*static_cast<std::uint64_t *>(dyntracer->state));
+}
+
+static void destroy_calibration(dyntracer_t *dyntracer) {
+    if (dyntracer) {
+        delete static_cast<std::uint64_t *>(dyntracer->state);
+        free(dyntracer);
+    }
+}
+
+SEXP destroy_calibration_dyntracer(SEXP dyntracer_sexp) {
+    return dyntracer_destroy_sexp(dyntracer_sexp, destroy_calibration);
+}
+
 } // extern "C"
@@ -11,10 +11,22 @@ extern "C" {
 
 SEXP create_dyntracer(SEXP trace_filepath, SEXP truncate, SEXP enable_trace,
                       SEXP verbose, SEXP output_dir, SEXP binary,
-                      SEXP compression_level, SEXP analysis_switch_env);
+                      SEXP compression_level, SEXP analysis_switch_env,
+                      SEXP allowed_namespaces, SEXP denied_namespaces,
+                      SEXP allowed_functions, SEXP denied_functions);
 
 SEXP destroy_dyntracer(SEXP tracer);
 
+SEXP get_memory_usage(SEXP tracer);
+
+SEXP add_metadata(SEXP tracer, SEXP metadata);
+
+SEXP create_calibration_dyntracer(SEXP probe_family);
+
+SEXP get_calibration_event_count(SEXP tracer);
+
+SEXP destroy_calibration_dyntracer(SEXP tracer);
+
 #ifdef __cplusplus
 }
 #endif
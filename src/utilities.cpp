@@ -2,15 +2,12 @@
 #include "base64.h"
 #include "lookup.h"
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
 
 size_t SQLITE3_ERROR_MESSAGE_BUFFER_SIZE = 1000;
 size_t SQLITE3_EXPANDED_SQL_BUFFER_SIZE = 2000;
 
-/* https://stackoverflow.com/questions/8206387/using-non-printable-characters-as-a-delimiter-in-php
- */
-const char RECORD_SEPARATOR = 0x1e;
-const char UNIT_SEPARATOR = 0x1f;
-
 int get_file_size(std::ifstream &file) {
     int position = file.tellg();
     file.seekg(0, std::ios_base::end);
@@ -29,10 +26,6 @@ std::string readfile(std::ifstream &file) {
     return contents;
 }
 
-bool file_exists(const std::string &filepath) {
-    return std::ifstream(filepath).good();
-}
-
 char *copy_string(char *destination, const char *source, size_t buffer_size) {
     size_t l = strlen(source);
     if (l >= buffer_size) {
@@ -143,7 +136,7 @@ static const char *get_filename(SEXP srcref) {
     return NULL;
 }
 
-inline std::string extract_location_information(SEXP srcref) {
+std::string extract_location_information(SEXP srcref) {
     const char *filename = get_filename(srcref);
     int lineno = get_lineno(srcref);
     int colno = get_colno(srcref);
@@ -157,16 +150,6 @@ inline std::string extract_location_information(SEXP srcref) {
         return "";
 }
 
-std::string get_callsite_cpp(int how_far_in_the_past) {
-    SEXP srcref = R_GetCurrentSrcref(how_far_in_the_past);
-    return extract_location_information(srcref);
-}
-
-std::string get_definition_location_cpp(SEXP op) {
-    SEXP srcref = getAttrib(op, R_SrcrefSymbol);
-    return extract_location_information(srcref);
-}
-
 int is_byte_compiled(SEXP op) {
     SEXP body = BODY(op);
     return TYPEOF(body) == BCODESXP;
@@ -174,6 +157,12 @@ int is_byte_compiled(SEXP op) {
 
 std::string get_expression(SEXP e) {
     std::string expression;
+    get_expression(e, expression);
+    return expression;
+}
+
+void get_expression(SEXP e, std::string &expression) {
+    expression.clear();
     int linecount = 0;
     SEXP strvec = serialize_sexp(e, &linecount);
     for (int i = 0; i < linecount - 1; ++i) {
@@ -182,7 +171,6 @@ std::string get_expression(SEXP e) {
     if (linecount >= 1) {
         expression.append(CHAR(STRING_ELT(strvec, linecount - 1)));
     }
-    return expression;
 }
 
 std::string escape(const std::string &s) {
@@ -277,11 +265,35 @@ std::string clock_ticks_to_string(clock_t ticks) {
 
 AnalysisSwitch to_analysis_switch(SEXP env) {
 
+    /* an option which is not bound in env takes its default value */
+    auto find_option = [&](const std::string &name) {
+        return Rf_findVar(Rf_install(name.c_str()), env);
+    };
+
+    auto get_flag = [&](const std::string &name, bool default_value) {
+        SEXP value = find_option(name);
+        return (value == R_UnboundValue) ? default_value : sexp_to_bool(value);
+    };
+
+    auto get_int = [&](const std::string &name, int default_value) {
+        SEXP value = find_option(name);
+        return (value == R_UnboundValue) ? default_value : Rf_asInteger(value);
+    };
+
+    auto get_real = [&](const std::string &name, double default_value) {
+        SEXP value = find_option(name);
+        return (value == R_UnboundValue) ? default_value : Rf_asReal(value);
+    };
+
+    auto get_string = [&](const std::string &name,
+                          const std::string &default_value) {
+        SEXP value = find_option(name);
+        return (value == R_UnboundValue) ? default_value
+                                         : sexp_to_string(value);
+    };
+
     auto get_switch = [&](const std::string analysis_name) {
-        SEXP name =
-            Rf_install(("enable_" + analysis_name + "_analysis").c_str());
-        SEXP value = Rf_findVar(name, env);
-        return (value == R_UnboundValue) ? true : sexp_to_bool(value);
+        return get_flag("enable_" + analysis_name + "_analysis", true);
     };
 
     AnalysisSwitch analysis_switch;
@@ -295,6 +307,61 @@ AnalysisSwitch to_analysis_switch(SEXP env) {
     analysis_switch.strictness = get_switch("strictness");
     analysis_switch.side_effect = get_switch("side_effect");
 
+    analysis_switch.aggregate_parameter_usage =
+        get_flag("aggregate_parameter_usage", false);
+    analysis_switch.memory_timeline = get_flag("memory_timeline", false);
+    analysis_switch.record_events = get_flag("record_events", false);
+
+    /* Rf_error does not return, so the mode string is destroyed before it
+       is called */
+    bool known_mode = true;
+    char unknown_mode[64];
+    {
+        std::string mode = get_string("sampling_mode", "none");
+        if (mode == "none") {
+            analysis_switch.sampling_mode = sampling_mode_t::NONE;
+        } else if (mode == "top_level") {
+            analysis_switch.sampling_mode = sampling_mode_t::TOP_LEVEL;
+        } else if (mode == "function") {
+            analysis_switch.sampling_mode = sampling_mode_t::FUNCTION;
+        } else if (mode == "call") {
+            analysis_switch.sampling_mode = sampling_mode_t::CALL;
+        } else {
+            known_mode = false;
+            std::snprintf(unknown_mode, sizeof(unknown_mode), "%s",
+                          mode.c_str());
+        }
+    }
+    if (!known_mode)
+        Rf_error("unknown sampling mode '%s', expected one of none, "
+                 "top_level, function or call",
+                 unknown_mode);
+
+    analysis_switch.sampling_rate = get_int("sampling_rate", 1);
+    if (analysis_switch.sampling_rate < 1)
+        Rf_error("sampling rate must be at least 1, got %d",
+                 analysis_switch.sampling_rate);
+
+    /* the limit is converted to an unsigned 64 bit count, NA fails all of
+       these comparisons */
+    analysis_switch.degradation_call_limit =
+        get_real("degradation_call_limit", 0);
+    if (!(analysis_switch.degradation_call_limit >= 0 &&
+          analysis_switch.degradation_call_limit < 0x1p64 &&
+          std::floor(analysis_switch.degradation_call_limit) ==
+              analysis_switch.degradation_call_limit))
+        Rf_error("degradation call limit must be a non-negative whole "
+                 "number below 2^64, got %g",
+                 analysis_switch.degradation_call_limit);
+
+    analysis_switch.degradation_call_rate =
+        get_real("degradation_call_rate", 0);
+    if (!(analysis_switch.degradation_call_rate >= 0 &&
+          std::isfinite(analysis_switch.degradation_call_rate)))
+        Rf_error("degradation call rate must be a non-negative finite "
+                 "number of calls per second, got %g",
+                 analysis_switch.degradation_call_rate);
+
     return analysis_switch;
 }
 
@@ -5,9 +5,6 @@
 #include "stdlibs.h"
 #include <openssl/evp.h>
 
-extern const char UNIT_SEPARATOR;
-extern const char RECORD_SEPARATOR;
-
 #define failwith(format, ...)                                                  \
     failwith_impl(__FILE__, __LINE__, format, __VA_ARGS__)
 
@@ -21,8 +18,6 @@ int get_file_size(std::ifstream &file);
 
 std::string readfile(std::ifstream &file);
 
-bool file_exists(const std::string &filepath);
-
 char *copy_string(char *destination, const char *source, size_t buffer_size);
 
 bool sexp_to_bool(SEXP value);
@@ -32,18 +27,20 @@ int sexp_to_int(SEXP value);
 std::string sexp_to_string(SEXP value);
 
 template <typename T>
-typename std::underlying_type<T>::type to_underlying_type(const T &enum_val) {
+constexpr typename std::underlying_type<T>::type
+to_underlying_type(const T &enum_val) {
     return static_cast<typename std::underlying_type<T>::type>(enum_val);
 }
 
 std::string compute_hash(const char *data);
 const char *get_ns_name(SEXP op);
 const char *get_name(SEXP call);
-std::string get_definition_location_cpp(SEXP op);
-std::string get_callsite_cpp(int);
+std::string extract_location_information(SEXP srcref);
 int is_byte_compiled(SEXP op);
 // char *to_string(SEXP var);
 std::string get_expression(SEXP e);
+/* same as above, but reuses the storage of expression */
+void get_expression(SEXP e, std::string &expression);
 std::string escape(const std::string &s);
 const char *remove_null(const char *value);
 std::string clock_ticks_to_string(clock_t ticks);
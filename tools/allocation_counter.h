@@ -0,0 +1,37 @@
+#ifndef PROMISEDYNTRACER_ALLOCATION_COUNTER_H
+#define PROMISEDYNTRACER_ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+/* Allocations are counted by interposing the allocator. operator new goes
+   through malloc, so this also counts the allocations of the standard
+   containers. The allocator functions are defined here, so this header is
+   included by the file holding the main function of a tool only. */
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *pointer, std::size_t size);
+
+static std::size_t allocation_count = 0;
+static std::size_t allocated_bytes = 0;
+
+void *malloc(std::size_t size) {
+    ++allocation_count;
+    allocated_bytes += size;
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size) {
+    ++allocation_count;
+    allocated_bytes += count * size;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, std::size_t size) {
+    ++allocation_count;
+    allocated_bytes += size;
+    return __libc_realloc(pointer, size);
+}
+}
+
+#endif /* PROMISEDYNTRACER_ALLOCATION_COUNTER_H */
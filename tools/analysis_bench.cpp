@@ -0,0 +1,760 @@
+/* Measures the cost per event of each analysis on synthetic event streams,
+   without running R. The generator produces the info structures the
+   recorder would produce for nested closure calls with promise arguments,
+   builtin calls, variable definitions and lookups and garbage collection
+   of promises and environments. SEXPs are only used as keys by the
+   analyses measured here, so they are made up addresses.
+
+   Before measuring, the state of the analyses is grown to the given number
+   of live promises, which are never collected, to show how the cost scales
+   with the size of the state. Each analysis is measured on its own, and
+   the cost of the generator and of the stack, measured without any
+   analysis, is reported so that it can be subtracted. The strictness and
+   promise evaluation analyses need the promise mapper, so the cost of the
+   mapper is subtracted from theirs. The allocations per event are counted
+   alongside, the generator fills the info structures from the pools of the
+   tracer state and maintains the stack as the probes do, and recycles its
+   own storage, so that the allocations measured without any analysis are
+   those of the probe path outside of R. The output is csv, one row per
+   analysis and live state size, tagged with the commit, so that the output
+   of different versions can be concatenated and compared.
+
+   usage: analysis_bench [--events N] [--depth N] [--arguments N]
+                         [--lifetime N] [--evaluated P] [--variables N]
+                         [--live N,N,...] [--repetitions N]
+                         [--directory DIR] [--aggregate-parameter-usage]
+                         [analysis ...] */
+
+#include "FunctionAnalysis.h"
+#include "PromiseEvaluationAnalysis.h"
+#include "PromiseMapper.h"
+#include "PromiseTypeAnalysis.h"
+#include "SideEffectAnalysis.h"
+#include "StrictnessAnalysis.h"
+#include "allocation_counter.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct options_t {
+    std::size_t events = 1000000;
+    int depth = 16;
+    int arguments = 3;
+    /* number of calls after which the promises and the environment of a
+       call are collected */
+    std::size_t lifetime = 64;
+    /* fraction of the argument promises which are forced */
+    double evaluated = 0.8;
+    int variables = 2;
+    std::vector<std::size_t> live = {1000, 10000, 100000, 1000000};
+    int repetitions = 3;
+    std::string directory = "/tmp";
+    bool aggregate_parameter_usage = false;
+    std::vector<std::string> analyses;
+};
+
+/* xorshift, so that every analysis sees the same stream */
+class Generator {
+  public:
+    explicit Generator(std::uint64_t seed = 0x9e3779b97f4a7c15)
+        : state_{seed} {}
+
+    std::uint64_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+    std::size_t next(std::size_t bound) { return next() % bound; }
+
+    double next_fraction() { return (next() >> 11) * 0x1.0p-53; }
+
+  private:
+    std::uint64_t state_;
+};
+
+/* receives the events of the stream, the default is no analysis */
+class Target {
+  public:
+    virtual ~Target() {}
+    virtual void promise_created(const prom_basic_info_t &info) {}
+    virtual void closure_entry(const closure_info_t &info) {}
+    virtual void closure_exit(const closure_info_t &info) {}
+    virtual void builtin_entry(const builtin_info_t &info) {}
+    virtual void builtin_exit(const builtin_info_t &info) {}
+    virtual void promise_force_entry(const prom_info_t &info) {}
+    virtual void promise_force_exit(const prom_info_t &info) {}
+    virtual void promise_value_lookup(const prom_info_t &info) {}
+    virtual void environment_define_var(const std::string &symbol,
+                                        const SEXP rho) {}
+    virtual void environment_lookup_var(const std::string &symbol,
+                                        const SEXP rho) {}
+    virtual void gc_promise_unmarked(prom_id_t prom_id, bool forced) {}
+    virtual void gc_environment_unmarked(const SEXP rho) {}
+};
+
+class PromiseMapperTarget : public Target {
+  public:
+    PromiseMapperTarget(tracer_state_t &tracer_state,
+                        const std::string &output_dir)
+        : promise_mapper_{tracer_state, output_dir, true, true, 0} {}
+
+    void promise_created(const prom_basic_info_t &info) override {
+        promise_mapper_.promise_created(info, nullptr);
+    }
+
+    void closure_entry(const closure_info_t &info) override {
+        promise_mapper_.closure_entry(info);
+    }
+
+    void promise_force_entry(const prom_info_t &info) override {
+        promise_mapper_.promise_force_entry(info, nullptr);
+    }
+
+    void promise_value_lookup(const prom_info_t &info) override {
+        promise_mapper_.promise_value_lookup(info, nullptr);
+    }
+
+    void gc_promise_unmarked(prom_id_t prom_id, bool forced) override {
+        promise_mapper_.gc_promise_unmarked(prom_id, nullptr);
+    }
+
+  protected:
+    PromiseMapper promise_mapper_;
+};
+
+class StrictnessTarget : public PromiseMapperTarget {
+  public:
+    StrictnessTarget(tracer_state_t &tracer_state,
+                     const std::string &output_dir,
+                     bool aggregate_parameter_usage)
+        : PromiseMapperTarget(tracer_state, output_dir),
+          strictness_analysis_{tracer_state, &promise_mapper_, output_dir,
+                               true, true, 0, aggregate_parameter_usage} {}
+
+    void closure_entry(const closure_info_t &info) override {
+        PromiseMapperTarget::closure_entry(info);
+        strictness_analysis_.closure_entry(info);
+    }
+
+    void closure_exit(const closure_info_t &info) override {
+        strictness_analysis_.closure_exit(info);
+    }
+
+    void promise_force_entry(const prom_info_t &info) override {
+        PromiseMapperTarget::promise_force_entry(info);
+        strictness_analysis_.promise_force_entry(info, nullptr);
+    }
+
+    void promise_value_lookup(const prom_info_t &info) override {
+        PromiseMapperTarget::promise_value_lookup(info);
+        strictness_analysis_.promise_value_lookup(info, nullptr);
+    }
+
+  private:
+    StrictnessAnalysis strictness_analysis_;
+};
+
+class PromiseEvaluationTarget : public PromiseMapperTarget {
+  public:
+    PromiseEvaluationTarget(tracer_state_t &tracer_state,
+                            const std::string &output_dir)
+        : PromiseMapperTarget(tracer_state, output_dir),
+          promise_evaluation_analysis_{tracer_state, output_dir,
+                                       &promise_mapper_} {}
+
+    void promise_force_entry(const prom_info_t &info) override {
+        PromiseMapperTarget::promise_force_entry(info);
+        promise_evaluation_analysis_.promise_force_entry(info, nullptr);
+    }
+
+  private:
+    PromiseEvaluationAnalysis promise_evaluation_analysis_;
+};
+
+class SideEffectTarget : public Target {
+  public:
+    SideEffectTarget(tracer_state_t &tracer_state,
+                     const std::string &output_dir)
+        : side_effect_analysis_{tracer_state, output_dir, true, true, 0} {}
+
+    void promise_created(const prom_basic_info_t &info) override {
+        side_effect_analysis_.promise_created(info, nullptr);
+    }
+
+    void environment_define_var(const std::string &symbol,
+                                const SEXP rho) override {
+        side_effect_analysis_.environment_define_var(symbol, rho);
+    }
+
+    void environment_lookup_var(const std::string &symbol,
+                                const SEXP rho) override {
+        side_effect_analysis_.environment_lookup_var(symbol, rho);
+    }
+
+    void gc_promise_unmarked(prom_id_t prom_id, bool forced) override {
+        side_effect_analysis_.gc_promise_unmarked(prom_id, nullptr);
+    }
+
+    void gc_environment_unmarked(const SEXP rho) override {
+        side_effect_analysis_.gc_environment_unmarked(rho);
+    }
+
+  private:
+    SideEffectAnalysis side_effect_analysis_;
+};
+
+class FunctionTarget : public Target {
+  public:
+    FunctionTarget(tracer_state_t &tracer_state, const std::string &output_dir)
+        : function_analysis_{tracer_state, output_dir, true, true, 0} {}
+
+    void closure_entry(const closure_info_t &info) override {
+        function_analysis_.closure_entry(info);
+    }
+
+    void closure_exit(const closure_info_t &info) override {
+        function_analysis_.closure_exit(info);
+    }
+
+    void builtin_entry(const builtin_info_t &info) override {
+        function_analysis_.builtin_entry(info);
+    }
+
+    void builtin_exit(const builtin_info_t &info) override {
+        function_analysis_.builtin_exit(info);
+    }
+
+  private:
+    FunctionAnalysis function_analysis_;
+};
+
+class PromiseTypeTarget : public Target {
+  public:
+    PromiseTypeTarget(tracer_state_t &tracer_state,
+                      const std::string &output_dir)
+        : promise_type_analysis_{tracer_state, output_dir} {}
+
+    void promise_created(const prom_basic_info_t &info) override {
+        promise_type_analysis_.promise_created(info, nullptr);
+    }
+
+    void closure_entry(const closure_info_t &info) override {
+        promise_type_analysis_.closure_entry(info);
+    }
+
+    void promise_force_exit(const prom_info_t &info) override {
+        promise_type_analysis_.promise_force_exit(info, nullptr);
+    }
+
+    /* collecting an unforced promise reads its expression and value, which
+       is not possible without R, so only forced promises are collected */
+    void gc_promise_unmarked(prom_id_t prom_id, bool forced) override {
+        if (forced)
+            promise_type_analysis_.gc_promise_unmarked(prom_id, nullptr);
+    }
+
+  private:
+    PromiseTypeAnalysis promise_type_analysis_;
+};
+
+/* Generates nested closure calls. Every call creates its argument promises
+   in the environment of the caller, enters the closure, defines variables,
+   forces some of the promises, each of which calls a builtin and looks up a
+   variable of the caller, calls between zero and two closures one level
+   deeper, looks up its variables and exits. The promises and the
+   environment of a call are collected lifetime calls after it exits. The
+   stack of the tracer state is maintained as the probes do. */
+class EventGenerator {
+  public:
+    EventGenerator(tracer_state_t &tracer_state, Target &target,
+                   const options_t &options)
+        : tracer_state_{tracer_state}, target_{target}, options_{options},
+          retired_head_{0}, event_count_{0}, call_count_{0},
+          promise_count_{0}, environment_count_{0}, keep_promises_{false} {
+
+        char id[33];
+        for (int index = 0; index < FUNCTION_COUNT; ++index) {
+            std::snprintf(id, sizeof(id), "%016llx%016llx",
+                          static_cast<unsigned long long>(generator_.next()),
+                          static_cast<unsigned long long>(index));
+            closure_info_t info{};
+            info.fn_type = function_type::CLOSURE;
+            info.fn_id = id;
+            info.fn_definition = "function(x) x";
+            info.name = "function_" + std::to_string(index);
+            info.formal_parameter_count = options.arguments;
+            info.return_value_type = REALSXP;
+            closures_.push_back(info);
+        }
+
+        builtin_.fn_type = function_type::BUILTIN;
+        builtin_.fn_id = "builtin";
+        builtin_.interned_fn_id = &builtin_.fn_id;
+        builtin_.fn_definition = "function(e1, e2) .Primitive(\"+\")";
+        builtin_.name = "+";
+        builtin_.formal_parameter_count = 2;
+        builtin_.return_value_type = REALSXP;
+
+        for (int index = 0; index < options.variables; ++index) {
+            variables_.push_back("variable_" + std::to_string(index));
+        }
+
+        /* the global environment */
+        environments_.push_back(next_environment_());
+    }
+
+    std::size_t get_event_count() const { return event_count_; }
+
+    /* generates calls until the given number of promises has been created,
+       these promises are never collected */
+    void grow(prom_id_t promise_count) {
+        keep_promises_ = true;
+        while (promise_count_ < promise_count) {
+            call_(1);
+        }
+        keep_promises_ = false;
+    }
+
+    /* generates calls until the given number of events has been sent */
+    void run(std::size_t event_count) {
+        std::size_t limit = event_count_ + event_count;
+        while (event_count_ < limit) {
+            call_(1);
+        }
+    }
+
+  private:
+    static constexpr int FUNCTION_COUNT = 256;
+
+    struct retired_call_t {
+        std::size_t expiry;
+        SEXP environment;
+        std::vector<std::pair<prom_id_t, bool>> promises;
+    };
+
+    SEXP next_environment_() {
+        return reinterpret_cast<SEXP>(0x10000 + 64 * ++environment_count_);
+    }
+
+    /* fills a pooled closure info the way the recorder does */
+    void fill_closure_(closure_info_t &info, const closure_info_t &function,
+                       call_id_t call_id, SEXP caller_environment,
+                       const retired_call_t &retired) {
+        info.fn_type = function.fn_type;
+        info.fn_id = function.fn_id;
+        info.interned_fn_id = &function.fn_id;
+        info.fn_definition = function.fn_definition;
+        info.name = function.name;
+        info.formal_parameter_count = function.formal_parameter_count;
+        info.return_value_type = function.return_value_type;
+        info.call_id = call_id;
+        info.call_ptr = get_sexp_address(retired.environment);
+        info.arguments.clear();
+
+        for (std::size_t position = 0; position < retired.promises.size();
+             ++position) {
+            info.arguments.emplace_back();
+            arg_t &argument = info.arguments.back();
+            argument.id = position;
+            argument.name = "x";
+            argument.value_type = PROMSXP;
+            argument.promise_id = retired.promises[position].first;
+            argument.promise_environment = caller_environment;
+            argument.parameter_mode = parameter_mode_t::CUSTOM;
+            argument.formal_parameter_position = position;
+        }
+    }
+
+    void call_(int depth) {
+        const closure_info_t &function =
+            closures_[generator_.next(FUNCTION_COUNT)];
+        SEXP caller_environment = environments_.back();
+        SEXP environment = next_environment_();
+        call_id_t call_id = ++call_count_;
+
+        retired_call_t retired{0, environment, take_promises_()};
+
+        for (int position = 0; position < options_.arguments; ++position) {
+            auto slot = tracer_state_.promise_basic_infos.acquire();
+            prom_basic_info_t &promise = slot.get();
+            promise.prom_id = ++promise_count_;
+            promise.promise_environment = caller_environment;
+            promise.prom_type = LANGSXP;
+            target_.promise_created(promise);
+            retired.promises.push_back({promise.prom_id, false});
+            ++event_count_;
+        }
+
+        stack_event_t frame;
+        frame.type = stack_type::CALL;
+        frame.call_id = call_id;
+        frame.function_info.function_id = &function.fn_id;
+        frame.function_info.type = function_type::CLOSURE;
+        frame.enclosing_environment = get_sexp_address(environment);
+        tracer_state_.push_stack(frame);
+        environments_.push_back(environment);
+        {
+            auto slot = tracer_state_.closure_infos.acquire();
+            closure_info_t &info = slot.get();
+            fill_closure_(info, function, call_id, caller_environment,
+                          retired);
+            target_.closure_entry(info);
+            ++event_count_;
+        }
+
+        for (const std::string &variable : variables_) {
+            target_.environment_define_var(variable, environment);
+            ++event_count_;
+        }
+
+        for (auto &promise : retired.promises) {
+            promise.second = generator_.next_fraction() < options_.evaluated;
+            if (promise.second) {
+                force_(promise.first, caller_environment, call_id);
+            }
+        }
+
+        if (depth < options_.depth) {
+            for (std::size_t child = generator_.next(3); child > 0; --child) {
+                call_(depth + 1);
+            }
+        }
+
+        for (const std::string &variable : variables_) {
+            target_.environment_lookup_var(variable, environment);
+            ++event_count_;
+        }
+
+        tracer_state_.pop_stack();
+        environments_.pop_back();
+        {
+            auto slot = tracer_state_.closure_infos.acquire();
+            closure_info_t &info = slot.get();
+            fill_closure_(info, function, call_id, caller_environment,
+                          retired);
+            target_.closure_exit(info);
+            ++event_count_;
+        }
+
+        if (keep_promises_) {
+            retired.promises.clear();
+        }
+        retired.expiry = call_count_ + options_.lifetime;
+        retired_calls_.push_back(std::move(retired));
+        collect_();
+    }
+
+    void force_(prom_id_t prom_id, SEXP environment, call_id_t call_id) {
+        auto slot = tracer_state_.promise_infos.acquire();
+        prom_info_t &info = slot.get();
+        info.prom_id = prom_id;
+        info.promise_environment = environment;
+        info.prom_type = LANGSXP;
+        info.in_call_id = call_id;
+        info.return_type = OMEGASXP;
+
+        target_.promise_force_entry(info);
+        ++event_count_;
+
+        stack_event_t frame;
+        frame.type = stack_type::PROMISE;
+        frame.promise_id = prom_id;
+        frame.enclosing_environment =
+            tracer_state_.full_stack.back().enclosing_environment;
+        tracer_state_.push_stack(frame);
+
+        target_.environment_lookup_var(variables_.empty() ? "x"
+                                                          : variables_[0],
+                                       environment);
+        ++event_count_;
+
+        call_id_t builtin_call_id = ++call_count_;
+        frame.type = stack_type::CALL;
+        frame.call_id = builtin_call_id;
+        frame.function_info.function_id = &builtin_.fn_id;
+        frame.function_info.type = function_type::BUILTIN;
+        {
+            auto builtin_slot = tracer_state_.builtin_infos.acquire();
+            builtin_info_t &builtin = builtin_slot.get();
+            builtin = builtin_;
+            builtin.call_id = builtin_call_id;
+            tracer_state_.push_stack(frame);
+            target_.builtin_entry(builtin);
+        }
+        {
+            auto builtin_slot = tracer_state_.builtin_infos.acquire();
+            builtin_info_t &builtin = builtin_slot.get();
+            builtin = builtin_;
+            builtin.call_id = builtin_call_id;
+            tracer_state_.pop_stack();
+            target_.builtin_exit(builtin);
+        }
+        event_count_ += 2;
+
+        info.return_type = REALSXP;
+        target_.promise_force_exit(info);
+        tracer_state_.pop_stack();
+        target_.promise_value_lookup(info);
+        event_count_ += 2;
+    }
+
+    std::vector<std::pair<prom_id_t, bool>> take_promises_() {
+        std::vector<std::pair<prom_id_t, bool>> promises;
+        if (spare_promises_.empty()) {
+            promises.reserve(options_.arguments);
+        } else {
+            promises = std::move(spare_promises_.back());
+            spare_promises_.pop_back();
+            promises.clear();
+        }
+        return promises;
+    }
+
+    /* the retired calls are a queue in a vector, which is compacted once
+       half of it has been collected, so that it stops allocating */
+    void collect_() {
+        while (retired_head_ < retired_calls_.size() &&
+               retired_calls_[retired_head_].expiry <= call_count_) {
+            retired_call_t &retired = retired_calls_[retired_head_];
+            for (const auto &promise : retired.promises) {
+                target_.gc_promise_unmarked(promise.first, promise.second);
+                ++event_count_;
+            }
+            target_.gc_environment_unmarked(retired.environment);
+            tracer_state_.remove_environment(retired.environment);
+            ++event_count_;
+            spare_promises_.push_back(std::move(retired.promises));
+            ++retired_head_;
+        }
+        if (2 * retired_head_ >= retired_calls_.size()) {
+            retired_calls_.erase(retired_calls_.begin(),
+                                 retired_calls_.begin() + retired_head_);
+            retired_head_ = 0;
+        }
+    }
+
+    tracer_state_t &tracer_state_;
+    Target &target_;
+    const options_t &options_;
+    Generator generator_;
+    std::vector<closure_info_t> closures_;
+    builtin_info_t builtin_;
+    std::vector<std::string> variables_;
+    std::vector<SEXP> environments_;
+    std::vector<retired_call_t> retired_calls_;
+    std::size_t retired_head_;
+    std::vector<std::vector<std::pair<prom_id_t, bool>>> spare_promises_;
+    std::size_t event_count_;
+    call_id_t call_count_;
+    prom_id_t promise_count_;
+    std::size_t environment_count_;
+    bool keep_promises_;
+};
+
+static const std::vector<std::string> ANALYSES = {
+    "none",         "promise_mapper", "strictness",  "promise_evaluation",
+    "side_effect",  "function",       "promise_type"};
+
+/* the measurement subtracted from the analysis to get its own cost */
+static std::string get_baseline(const std::string &analysis) {
+    if (analysis == "none")
+        return "";
+    if (analysis == "strictness" || analysis == "promise_evaluation")
+        return "promise_mapper";
+    return "none";
+}
+
+static std::unique_ptr<Target> make_target(const std::string &analysis,
+                                           tracer_state_t &tracer_state,
+                                           const options_t &options) {
+    const std::string &output_dir = options.directory;
+    if (analysis == "promise_mapper")
+        return std::unique_ptr<Target>(
+            new PromiseMapperTarget(tracer_state, output_dir));
+    if (analysis == "strictness")
+        return std::unique_ptr<Target>(new StrictnessTarget(
+            tracer_state, output_dir, options.aggregate_parameter_usage));
+    if (analysis == "promise_evaluation")
+        return std::unique_ptr<Target>(
+            new PromiseEvaluationTarget(tracer_state, output_dir));
+    if (analysis == "side_effect")
+        return std::unique_ptr<Target>(
+            new SideEffectTarget(tracer_state, output_dir));
+    if (analysis == "function")
+        return std::unique_ptr<Target>(
+            new FunctionTarget(tracer_state, output_dir));
+    if (analysis == "promise_type")
+        return std::unique_ptr<Target>(
+            new PromiseTypeTarget(tracer_state, output_dir));
+    return std::unique_ptr<Target>(new Target());
+}
+
+/* costs per event */
+struct measurement_t {
+    double nanoseconds;
+    double allocations;
+};
+
+/* returns the fastest of the repetitions */
+static measurement_t measure(const std::string &analysis, std::size_t live,
+                             const options_t &options,
+                             std::size_t &event_count) {
+    measurement_t best{0, 0};
+    for (int repetition = 0; repetition < options.repetitions; ++repetition) {
+        tracer_state_t tracer_state;
+        std::unique_ptr<Target> target =
+            make_target(analysis, tracer_state, options);
+        EventGenerator generator(tracer_state, *target, options);
+        generator.grow(static_cast<prom_id_t>(live));
+
+        std::size_t start_count = generator.get_event_count();
+        std::size_t allocations = allocation_count;
+        auto start = std::chrono::steady_clock::now();
+        generator.run(options.events);
+        double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        allocations = allocation_count - allocations;
+        event_count = generator.get_event_count() - start_count;
+
+        measurement_t measurement{1e9 * seconds / event_count,
+                                  static_cast<double>(allocations) /
+                                      event_count};
+        if (repetition == 0 || measurement.nanoseconds < best.nanoseconds) {
+            best = measurement;
+        }
+    }
+    return best;
+}
+
+static std::vector<std::size_t> parse_sizes(const char *argument) {
+    std::vector<std::size_t> sizes;
+    const char *start = argument;
+    while (*start != '\0') {
+        char *end = nullptr;
+        double size = std::strtod(start, &end);
+        if (end == start) {
+            break;
+        }
+        sizes.push_back(static_cast<std::size_t>(size));
+        start = *end == ',' ? end + 1 : end;
+    }
+    return sizes;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [--events N] [--depth N] [--arguments N] "
+            "[--lifetime N] [--evaluated P] [--variables N] "
+            "[--live N,N,...] [--repetitions N] [--directory DIR] "
+            "[--aggregate-parameter-usage] [analysis ...]\n"
+            "analyses: promise_mapper strictness promise_evaluation "
+            "side_effect function promise_type\n",
+            program);
+}
+
+int main(int argc, char *argv[]) {
+    options_t options;
+
+    for (int index = 1; index < argc; ++index) {
+        std::string argument = argv[index];
+        bool has_value = index + 1 < argc;
+        if (argument == "--events" && has_value) {
+            options.events = std::strtod(argv[++index], nullptr);
+        } else if (argument == "--depth" && has_value) {
+            options.depth = std::max(1, std::atoi(argv[++index]));
+        } else if (argument == "--arguments" && has_value) {
+            options.arguments = std::max(0, std::atoi(argv[++index]));
+        } else if (argument == "--lifetime" && has_value) {
+            options.lifetime = std::strtoull(argv[++index], nullptr, 10);
+        } else if (argument == "--evaluated" && has_value) {
+            options.evaluated = std::atof(argv[++index]);
+        } else if (argument == "--variables" && has_value) {
+            options.variables = std::max(0, std::atoi(argv[++index]));
+        } else if (argument == "--live" && has_value) {
+            options.live = parse_sizes(argv[++index]);
+        } else if (argument == "--repetitions" && has_value) {
+            options.repetitions = std::max(1, std::atoi(argv[++index]));
+        } else if (argument == "--directory" && has_value) {
+            options.directory = argv[++index];
+        } else if (argument == "--aggregate-parameter-usage") {
+            options.aggregate_parameter_usage = true;
+        } else if (argument.compare(0, 2, "--") == 0 ||
+                   std::find(ANALYSES.begin(), ANALYSES.end(), argument) ==
+                       ANALYSES.end()) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        } else {
+            options.analyses.push_back(argument);
+        }
+    }
+
+    if (options.analyses.empty()) {
+        options.analyses.assign(ANALYSES.begin() + 1, ANALYSES.end());
+    }
+
+    std::printf("commit,analysis,live_promises,depth,arguments,lifetime,"
+                "evaluated,events,ns_per_event,baseline,"
+                "baseline_ns_per_event,net_ns_per_event,"
+                "allocations_per_event,baseline_allocations_per_event,"
+                "net_allocations_per_event\n");
+
+    std::string commit{GIT_COMMIT_INFO};
+    commit = commit.substr(0, commit.find(' '));
+
+    for (std::size_t live : options.live) {
+        /* baselines are measured once per size, before the analyses which
+           are measured against them */
+        std::unordered_map<std::string, measurement_t> measurements;
+        std::vector<std::string> analyses{"none"};
+        for (const std::string &analysis : options.analyses) {
+            const std::string baseline = get_baseline(analysis);
+            if (!baseline.empty() && baseline != "none" &&
+                std::find(analyses.begin(), analyses.end(), baseline) ==
+                    analyses.end()) {
+                analyses.push_back(baseline);
+            }
+            if (std::find(analyses.begin(), analyses.end(), analysis) ==
+                analyses.end()) {
+                analyses.push_back(analysis);
+            }
+        }
+
+        for (const std::string &analysis : analyses) {
+            std::size_t event_count = 0;
+            measurement_t measurement =
+                measure(analysis, live, options, event_count);
+            measurements[analysis] = measurement;
+
+            const std::string baseline = get_baseline(analysis);
+            measurement_t baseline_measurement =
+                baseline.empty() ? measurement_t{0, 0}
+                                 : measurements[baseline];
+
+            std::printf("%s,%s,%zu,%d,%d,%zu,%.2f,%zu,%.2f,%s,%.2f,%.2f,"
+                        "%.3f,%.3f,%.3f\n",
+                        commit.c_str(), analysis.c_str(), live, options.depth,
+                        options.arguments, options.lifetime, options.evaluated,
+                        event_count, measurement.nanoseconds, baseline.c_str(),
+                        baseline_measurement.nanoseconds,
+                        measurement.nanoseconds -
+                            baseline_measurement.nanoseconds,
+                        measurement.allocations,
+                        baseline_measurement.allocations,
+                        measurement.allocations -
+                            baseline_measurement.allocations);
+            std::fflush(stdout);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
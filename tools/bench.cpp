@@ -0,0 +1,376 @@
+/* Measures the throughput and the allocations of the stream and table stack
+   on synthetic rows and events, without running R. Every benchmark is run
+   a number of times and the fastest run is reported as one csv row on the
+   standard output, tagged with the commit the binary was built from, so
+   that the output of different versions can be concatenated and compared.
+
+   usage: bench [--repetitions N] [--megabytes N] [--rows N] [--events N]
+                [--directory DIR] [benchmark-prefix ...] */
+
+#include "BufferStream.h"
+#include "DataTableStream.h"
+#include "FileStream.h"
+#include "TraceSerializer.h"
+#include "ZstdCompressionStream.h"
+#include "allocation_counter.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+/* end of the stream stack which only counts the bytes it receives */
+class CountingStream : public Stream {
+  public:
+    CountingStream() : Stream(nullptr), bytes_{0} {}
+
+    void write(const void *buffer, std::size_t bytes) override {
+        bytes_ += bytes;
+    }
+
+    void flush() override {}
+
+    std::size_t get_bytes() const { return bytes_; }
+
+  private:
+    std::size_t bytes_;
+};
+
+/* xorshift, so that the synthetic data is the same on every run */
+class Generator {
+  public:
+    explicit Generator(std::uint64_t seed = 0x9e3779b97f4a7c15)
+        : state_{seed} {}
+
+    std::uint64_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+    std::size_t next(std::size_t bound) { return next() % bound; }
+
+  private:
+    std::uint64_t state_;
+};
+
+/* Function ids, names and types drawn from small pools, as in the tables
+   written by the analyses, so that the data compresses like real output. */
+struct row_generator_t {
+    row_generator_t() {
+        Generator generator(42);
+        char id[33];
+        for (int index = 0; index < 1024; ++index) {
+            std::snprintf(id, sizeof(id), "%016llx%016llx",
+                          static_cast<unsigned long long>(generator.next()),
+                          static_cast<unsigned long long>(generator.next()));
+            function_ids.push_back(id);
+            names.push_back("function_" + std::to_string(index));
+        }
+        types = {"Closure", "Builtin", "Special",  "Logical", "Integer",
+                 "Double",  "String",  "List",     "Null",    "Environment",
+                 "Promise", "Language", "Symbol"};
+    }
+
+    std::vector<std::string> function_ids;
+    std::vector<std::string> names;
+    std::vector<std::string> types;
+};
+
+static const row_generator_t &get_rows() {
+    static const row_generator_t rows;
+    return rows;
+}
+
+struct result_t {
+    std::string benchmark;
+    std::size_t operations;
+    std::size_t input_bytes;
+    std::size_t output_bytes;
+    double seconds;
+    std::size_t allocations;
+    std::size_t allocated_bytes;
+};
+
+struct options_t {
+    int repetitions = 3;
+    std::size_t megabytes = 64;
+    std::size_t rows = 1000000;
+    std::size_t events = 500000;
+    std::string directory = "/tmp";
+    std::vector<std::string> prefixes;
+};
+
+/* larger than the window of any compression level, so that zstd cannot
+   find the payload repeating itself */
+static const std::size_t PAYLOAD_SIZE = std::size_t{32} << 20;
+
+/* a benchmark fills in the operation and byte counts, the harness the rest */
+using benchmark_t = std::function<void(result_t &)>;
+
+static std::size_t file_size(const std::string &filepath) {
+    struct stat buffer;
+    return stat(filepath.c_str(), &buffer) == 0 ? buffer.st_size : 0;
+}
+
+/* function ids drawn from the pool interleaved with random words, so
+   that it compresses about as well as the tables */
+static const std::vector<char> &get_payload() {
+    static std::vector<char> payload;
+    if (!payload.empty()) {
+        return payload;
+    }
+    const row_generator_t &rows = get_rows();
+    Generator generator;
+    while (payload.size() < PAYLOAD_SIZE) {
+        const std::string &id =
+            rows.function_ids[generator.next(rows.function_ids.size())];
+        payload.insert(payload.end(), id.begin(), id.end());
+        std::uint64_t value = generator.next();
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        payload.insert(payload.end(), bytes, bytes + sizeof(value));
+    }
+    payload.resize(PAYLOAD_SIZE);
+    return payload;
+}
+
+/* writes the given number of megabytes in records of the given size */
+static void write_payload(Stream &stream, const options_t &options,
+                          std::size_t record_size, result_t &result) {
+    const char *payload = get_payload().data();
+    std::size_t bytes = options.megabytes << 20;
+    std::size_t offset = 0;
+    for (; result.input_bytes < bytes; result.input_bytes += record_size) {
+        stream.write(payload + offset, record_size);
+        offset = (offset + record_size) % PAYLOAD_SIZE;
+        ++result.operations;
+    }
+}
+
+/* the input bytes of a row are the bytes of its fields in memory */
+static void write_rows(DataTableStream *table, const options_t &options,
+                       result_t &result) {
+    const row_generator_t &rows = get_rows();
+    Generator generator;
+    for (std::size_t row = 0; row < options.rows; ++row) {
+        const std::string &id =
+            rows.function_ids[generator.next(rows.function_ids.size())];
+        const std::string &type = rows.types[generator.next(rows.types.size())];
+        const std::string &name = rows.names[generator.next(rows.names.size())];
+        table->write_row(id, type, static_cast<int>(generator.next(8)), name,
+                         static_cast<double>(generator.next(100000)),
+                         generator.next(2) == 0);
+        result.input_bytes += id.size() + type.size() + sizeof(int) +
+                              name.size() + sizeof(double) + sizeof(bool);
+        ++result.operations;
+    }
+}
+
+static std::vector<std::pair<std::string, benchmark_t>>
+make_benchmarks(const options_t &options) {
+    std::vector<std::pair<std::string, benchmark_t>> benchmarks;
+    const std::string directory = options.directory + "/";
+
+    for (std::size_t record_size : {8, 64, 1024}) {
+        benchmarks.push_back(
+            {"buffer_stream/" + std::to_string(record_size),
+             [=, &options](result_t &result) {
+                 CountingStream sink;
+                 {
+                     BufferStream stream(&sink, 1024 * 1024);
+                     write_payload(stream, options, record_size, result);
+                 }
+                 result.output_bytes = sink.get_bytes();
+             }});
+    }
+
+    for (int level : {1, 3, 9}) {
+        benchmarks.push_back(
+            {"zstd_compression_stream/" + std::to_string(level),
+             [=, &options](result_t &result) {
+                 CountingStream sink;
+                 {
+                     ZstdCompressionStream stream(&sink, level);
+                     write_payload(stream, options, 64, result);
+                 }
+                 result.output_bytes = sink.get_bytes();
+             }});
+    }
+
+    for (std::size_t record_size : {4096, 1024 * 1024}) {
+        benchmarks.push_back(
+            {"file_stream/" + std::to_string(record_size),
+             [=, &options](result_t &result) {
+                 std::string filepath = directory + "bench-file-stream";
+                 {
+                     FileStream stream(filepath,
+                                       O_WRONLY | O_CREAT | O_TRUNC);
+                     write_payload(stream, options, record_size, result);
+                 }
+                 result.output_bytes = file_size(filepath);
+                 std::remove(filepath.c_str());
+             }});
+    }
+
+    for (bool binary : {true, false}) {
+        for (int level : {0, 1, 3}) {
+            std::string name = binary ? "binary_data_table_stream/"
+                                      : "text_data_table_stream/";
+            benchmarks.push_back(
+                {name + std::to_string(level),
+                 [=, &options](result_t &result) {
+                     DataTableStream *table = create_data_table(
+                         directory + "bench-table",
+                         {"id", "type", "arguments", "name", "count",
+                          "compiled"},
+                         true, binary, level);
+                     std::string filepath = table->get_filepath();
+                     write_rows(table, options, result);
+                     delete table;
+                     result.output_bytes = file_size(filepath);
+                     std::remove(filepath.c_str());
+                 }});
+        }
+    }
+
+    for (bool enable : {true, false}) {
+        benchmarks.push_back(
+            {std::string("trace_serializer/") +
+                 (enable ? "enabled" : "disabled"),
+             [=, &options](result_t &result) {
+                 const row_generator_t &rows = get_rows();
+                 std::string filepath = directory + "bench-trace";
+                 Generator generator;
+                 {
+                     TraceSerializer serializer(filepath, true, enable);
+                     for (std::size_t event = 0; event < options.events;
+                          ++event) {
+                         int call_id = static_cast<int>(event);
+                         int promise_id = static_cast<int>(generator.next());
+                         const std::string &fn_id =
+                             rows.function_ids[generator.next(
+                                 rows.function_ids.size())];
+                         serializer.serialize(
+                             TraceSerializer::OPCODE_FUNCTION_BEGIN, fn_id,
+                             call_id, generator.next(1 << 20));
+                         serializer.serialize(
+                             TraceSerializer::OPCODE_PROMISE_CREATE,
+                             promise_id, generator.next(1 << 20));
+                         serializer.serialize(
+                             TraceSerializer::OPCODE_PROMISE_BEGIN,
+                             promise_id);
+                         serializer.serialize(
+                             TraceSerializer::OPCODE_PROMISE_FINISH,
+                             promise_id);
+                         serializer.serialize(
+                             TraceSerializer::OPCODE_FUNCTION_FINISH, fn_id,
+                             call_id);
+                         result.operations += 5;
+                     }
+                 }
+                 result.output_bytes = file_size(filepath);
+                 std::remove(filepath.c_str());
+             }});
+    }
+
+    return benchmarks;
+}
+
+static bool is_selected(const options_t &options, const std::string &name) {
+    if (options.prefixes.empty()) {
+        return true;
+    }
+    for (const std::string &prefix : options.prefixes) {
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static result_t run(const std::string &name, const benchmark_t &benchmark,
+                    const options_t &options) {
+    result_t best{};
+    for (int repetition = 0; repetition < options.repetitions; ++repetition) {
+        result_t result{name, 0, 0, 0, 0.0, 0, 0};
+        std::size_t allocations = allocation_count;
+        std::size_t bytes = allocated_bytes;
+        auto start = std::chrono::steady_clock::now();
+        benchmark(result);
+        result.seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        result.allocations = allocation_count - allocations;
+        result.allocated_bytes = allocated_bytes - bytes;
+        if (repetition == 0 || result.seconds < best.seconds) {
+            best = result;
+        }
+    }
+    return best;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [--repetitions N] [--megabytes N] [--rows N] "
+            "[--events N] [--directory DIR] [benchmark-prefix ...]\n",
+            program);
+}
+
+int main(int argc, char *argv[]) {
+    options_t options;
+
+    for (int index = 1; index < argc; ++index) {
+        std::string argument = argv[index];
+        bool has_value = index + 1 < argc;
+        if (argument == "--repetitions" && has_value) {
+            options.repetitions = std::max(1, std::atoi(argv[++index]));
+        } else if (argument == "--megabytes" && has_value) {
+            options.megabytes = std::strtoull(argv[++index], nullptr, 10);
+        } else if (argument == "--rows" && has_value) {
+            options.rows = std::strtoull(argv[++index], nullptr, 10);
+        } else if (argument == "--events" && has_value) {
+            options.events = std::strtoull(argv[++index], nullptr, 10);
+        } else if (argument == "--directory" && has_value) {
+            options.directory = argv[++index];
+        } else if (argument.compare(0, 2, "--") == 0) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        } else {
+            options.prefixes.push_back(argument);
+        }
+    }
+
+    std::printf("commit,benchmark,repetitions,operations,input_bytes,"
+                "output_bytes,seconds,operations_per_second,"
+                "megabytes_per_second,allocations,allocated_bytes\n");
+
+    /* only the hash of the commit, the rest is its message */
+    std::string commit{GIT_COMMIT_INFO};
+    commit = commit.substr(0, commit.find(' '));
+
+    /* generated before the first benchmark so that they are not measured */
+    get_rows();
+    get_payload();
+
+    for (const auto &benchmark : make_benchmarks(options)) {
+        if (!is_selected(options, benchmark.first)) {
+            continue;
+        }
+        result_t result = run(benchmark.first, benchmark.second, options);
+        std::printf("%s,%s,%d,%zu,%zu,%zu,%.6f,%.1f,%.2f,%zu,%zu\n",
+                    commit.c_str(), result.benchmark.c_str(),
+                    options.repetitions, result.operations,
+                    result.input_bytes, result.output_bytes, result.seconds,
+                    result.operations / result.seconds,
+                    result.input_bytes / result.seconds / (1024 * 1024),
+                    result.allocations, result.allocated_bytes);
+        std::fflush(stdout);
+    }
+
+    return EXIT_SUCCESS;
+}
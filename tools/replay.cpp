@@ -0,0 +1,276 @@
+/* Replays an event log recorded with the record_events switch into the
+   analyses, without running R. The recorded SEXPs are only addresses, so
+   only the analyses which use them as keys can be replayed: metadata,
+   object_count_size, function, strictness (with the promise mapping) and
+   side_effect. The stack of the tracer state is rebuilt from the events in
+   the order the probes maintain it. Several replays with different
+   analyses can run over the same log in parallel, each with its own output
+   directory.
+
+   usage: replay [--text] [--compression-level N]
+                 [--aggregate-parameter-usage]
+                 <event-log> <output-dir> [analysis ...] */
+
+#include "AnalysisDriver.h"
+#include "EventLog.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [--text] [--compression-level N] "
+            "[--aggregate-parameter-usage] <event-log> <output-dir> "
+            "[analysis ...]\n"
+            "analyses: metadata object_count_size function strictness "
+            "side_effect\n",
+            program);
+}
+
+static bool enable_analysis(AnalysisSwitch &analysis_switch,
+                            const std::string &name) {
+    if (name == "metadata") {
+        analysis_switch.metadata = true;
+    } else if (name == "object_count_size") {
+        analysis_switch.object_count_size = true;
+    } else if (name == "function") {
+        analysis_switch.function = true;
+    } else if (name == "strictness") {
+        analysis_switch.strictness = true;
+    } else if (name == "side_effect") {
+        analysis_switch.side_effect = true;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void push_call(tracer_state_t &tracer_state, const call_info_t &info) {
+    stack_event_t stack_elem;
+    stack_elem.type = stack_type::CALL;
+    stack_elem.call_id = info.call_id;
+    stack_elem.function_info.function_id = info.interned_fn_id;
+    stack_elem.function_info.type = info.fn_type;
+    stack_elem.enclosing_environment = info.call_ptr;
+    tracer_state.push_stack(stack_elem);
+}
+
+static void push_promise(tracer_state_t &tracer_state, prom_id_t prom_id) {
+    stack_event_t stack_elem;
+    stack_elem.type = stack_type::PROMISE;
+    stack_elem.promise_id = prom_id;
+    stack_elem.enclosing_environment =
+        tracer_state.full_stack.empty()
+            ? 0
+            : tracer_state.full_stack.back().enclosing_environment;
+    tracer_state.push_stack(stack_elem);
+}
+
+static void pop_frame(tracer_state_t &tracer_state) {
+    if (!tracer_state.full_stack.empty())
+        tracer_state.pop_stack();
+}
+
+/* the contexts are not recorded, so only the unwound calls and promises
+   are on the rebuilt stack */
+static void unwind(tracer_state_t &tracer_state, const unwind_info_t &info) {
+    for (const stack_event_t &frame : info.unwound_frames) {
+        if (frame.type != stack_type::CONTEXT)
+            pop_frame(tracer_state);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    bool binary = true;
+    int compression_level = 1;
+    AnalysisSwitch analysis_switch{};
+
+    int index = 1;
+    for (; index < argc && std::strncmp(argv[index], "--", 2) == 0; ++index) {
+        if (std::strcmp(argv[index], "--text") == 0) {
+            binary = false;
+        } else if (std::strcmp(argv[index], "--compression-level") == 0 &&
+                   index + 1 < argc) {
+            compression_level = std::atoi(argv[++index]);
+        } else if (std::strcmp(argv[index], "--aggregate-parameter-usage") ==
+                   0) {
+            analysis_switch.aggregate_parameter_usage = true;
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - index < 2) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::string event_log_filepath = argv[index++];
+    const std::string output_dir = argv[index++];
+
+    if (index == argc) {
+        for (const char *name : {"metadata", "object_count_size", "function",
+                                 "strictness", "side_effect"}) {
+            enable_analysis(analysis_switch, name);
+        }
+    }
+
+    for (; index < argc; ++index) {
+        if (!enable_analysis(analysis_switch, argv[index])) {
+            fprintf(stderr, "analysis %s cannot be replayed\n", argv[index]);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    EventLogReader reader(event_log_filepath);
+    tracer_state_t tracer_state;
+    AnalysisDriver driver(tracer_state, output_dir, true, binary,
+                          compression_level, analysis_switch);
+
+    /* the structures are reused so that their strings and vectors keep
+       their capacity from one event to the next. */
+    closure_info_t closure_info;
+    builtin_info_t builtin_info;
+    prom_basic_info_t prom_basic_info;
+    prom_info_t prom_info;
+    unwind_info_t unwind_info;
+    environment_action_t environment_action;
+    gc_info_t gc_info;
+    type_gc_info_t type_gc_info;
+    prom_id_t prom_id;
+    SEXP sexp;
+
+    std::size_t event_count = 0;
+    bool ended = false;
+    EventType type;
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (!ended && reader.next(type)) {
+        ++event_count;
+        switch (type) {
+            case EventType::CLOSURE_ENTRY:
+                reader.read(closure_info);
+                push_call(tracer_state, closure_info);
+                driver.closure_entry(closure_info);
+                break;
+            case EventType::CLOSURE_EXIT:
+                reader.read(closure_info);
+                pop_frame(tracer_state);
+                driver.closure_exit(closure_info);
+                break;
+            case EventType::SPECIAL_ENTRY:
+                reader.read(builtin_info);
+                driver.special_entry(builtin_info);
+                push_call(tracer_state, builtin_info);
+                break;
+            case EventType::SPECIAL_EXIT:
+                reader.read(builtin_info);
+                driver.special_exit(builtin_info);
+                pop_frame(tracer_state);
+                break;
+            case EventType::BUILTIN_ENTRY:
+                reader.read(builtin_info);
+                driver.builtin_entry(builtin_info);
+                push_call(tracer_state, builtin_info);
+                break;
+            case EventType::BUILTIN_EXIT:
+                reader.read(builtin_info);
+                driver.builtin_exit(builtin_info);
+                pop_frame(tracer_state);
+                break;
+            case EventType::PROMISE_CREATED:
+                reader.read(prom_basic_info, sexp);
+                driver.promise_created(prom_basic_info, sexp);
+                break;
+            case EventType::PROMISE_FORCE_ENTRY:
+                reader.read(prom_info, sexp);
+                driver.promise_force_entry(prom_info, sexp);
+                push_promise(tracer_state, prom_info.prom_id);
+                break;
+            case EventType::PROMISE_FORCE_EXIT:
+                reader.read(prom_info, sexp);
+                driver.promise_force_exit(prom_info, sexp);
+                pop_frame(tracer_state);
+                break;
+            case EventType::PROMISE_ENVIRONMENT_LOOKUP:
+                reader.read(prom_info, sexp);
+                driver.promise_environment_lookup(prom_info, sexp);
+                break;
+            case EventType::PROMISE_EXPRESSION_LOOKUP:
+                reader.read(prom_info, sexp);
+                driver.promise_expression_lookup(prom_info, sexp);
+                break;
+            case EventType::PROMISE_VALUE_LOOKUP:
+                reader.read(prom_info, sexp);
+                driver.promise_value_lookup(prom_info, sexp);
+                break;
+            case EventType::PROMISE_ENVIRONMENT_SET:
+                reader.read(prom_info, sexp);
+                driver.promise_environment_set(prom_info, sexp);
+                break;
+            case EventType::PROMISE_EXPRESSION_SET:
+                reader.read(prom_info, sexp);
+                driver.promise_expression_set(prom_info, sexp);
+                break;
+            case EventType::PROMISE_VALUE_SET:
+                reader.read(prom_info, sexp);
+                driver.promise_value_set(prom_info, sexp);
+                break;
+            case EventType::GC_PROMISE_UNMARKED:
+                reader.read_gc_promise_unmarked(prom_id, sexp);
+                driver.gc_promise_unmarked(prom_id, sexp);
+                break;
+            case EventType::GC_ENVIRONMENT_UNMARKED:
+                reader.read_gc_environment_unmarked(sexp);
+                driver.gc_environment_unmarked(sexp);
+                break;
+            case EventType::GC_EXIT:
+                reader.read(gc_info);
+                driver.gc_exit(gc_info);
+                break;
+            case EventType::VECTOR_ALLOC:
+                reader.read(type_gc_info);
+                driver.vector_alloc(type_gc_info);
+                break;
+            case EventType::ENVIRONMENT_DEFINE_VAR:
+            case EventType::ENVIRONMENT_ASSIGN_VAR:
+            case EventType::ENVIRONMENT_LOOKUP_VAR:
+            case EventType::ENVIRONMENT_REMOVE_VAR:
+                reader.read(environment_action);
+                driver.environment_action(type, environment_action);
+                break;
+            case EventType::CONTEXT_JUMP:
+                reader.read(unwind_info);
+                unwind(tracer_state, unwind_info);
+                driver.context_jump(unwind_info);
+                break;
+            case EventType::END:
+                ended = true;
+                break;
+            default:
+                fprintf(stderr, "unknown event %d in %s\n",
+                        static_cast<int>(type), event_log_filepath.c_str());
+                return EXIT_FAILURE;
+        }
+    }
+
+    /* a log without an end event comes from a run which did not finish,
+       the analyses are still asked to write what they have. */
+    driver.end(nullptr);
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    fprintf(stderr, "replayed %zu events in %.3f seconds (%.1f ns/event)%s\n",
+            event_count, seconds,
+            event_count == 0 ? 0.0 : 1e9 * seconds / event_count,
+            ended ? "" : ", log ended without end event");
+
+    return EXIT_SUCCESS;
+}